@@ -0,0 +1,90 @@
+#!/bin/bash
+
+# Measure what the debugging checks cost the simulator, with no -d
+# flags: build Nachos as usual, where each DEBUG tests a bit in the
+# flag mask, and with -DNO_DEBUG, where DEBUG is compiled out, and
+# time both on the same programs under each engine.
+#
+# Each build goes in a scratch directory next to build.linux, with the
+# same Makefile and DEFINES, so the objects in build.linux are left
+# alone.  Every program runs ROUNDS times per build and engine; the
+# best and the median time are reported, so that noise shows up as a
+# gap between the two.
+#
+# Usage: ./debugbench.sh [program ...]	(default: simbench)
+# The programs must end with Halt(), so that the statistics get printed.
+
+ENGINES=(ref batch threaded)
+VARIANTS=(bitmask nodebug)
+ROUNDS=7
+
+if [ $# -gt 0 ]; then
+    PROGS=("$@")
+else
+    PROGS=(simbench)
+fi
+
+# Check if script is in the right directory
+if [ ${PWD##*/} != "code" ]; then
+    echo -e "\n@@@@@ Script should be put in ./code @@@@@\n"
+    exit 1
+fi
+
+# Build nachos, once per variant
+echo -e "===== Make nachos ====="
+DEFINES=$(sed -n 's/^DEFINES = *//p' build.linux/Makefile)
+trap 'rm -rf build.bitmask build.nodebug' EXIT
+for variant in ${VARIANTS[@]}; do
+    if [ $variant = nodebug ]; then
+	flags="$DEFINES -DNO_DEBUG"
+    else
+	flags="$DEFINES"
+    fi
+    rm -rf build.$variant
+    mkdir build.$variant
+    cp build.linux/Makefile build.linux/Makefile.dep build.$variant/
+    (cd build.$variant && make -j2 DEFINES="$flags" nachos > /dev/null 2>&1)
+    if [ $? -ne 0 ]; then
+	echo -e "Nachos built failed with DEFINES = $flags"
+	exit 1
+    fi
+done
+
+# Build test programs
+echo -e "===== Make test programs ====="
+cd test
+make ${PROGS[@]} > /dev/null 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "Tests built failed"
+    exit 1
+fi
+
+# Start benchmark
+echo -e "===== Start benchmark ====="
+printf "%-12s %-10s %-9s %12s %8s %8s %14s\n" program engine build "user ticks" best median "instr/second"
+for prog in ${PROGS[@]}; do
+    for engine in ${ENGINES[@]}; do
+	for variant in ${VARIANTS[@]}; do
+	    times=()
+	    for ((r=0; r<$ROUNDS; r++)); do
+		start=$(date +%s%N)
+		out=$(../build.$variant/nachos -sim $engine -e $prog)
+		end=$(date +%s%N)
+		times+=($(($end - $start)))
+	    done
+	    user=$(echo "$out" | sed -n 's/^Ticks:.*user \([0-9]*\).*/\1/p')
+	    if [ -z "$user" ]; then
+		echo -e "$prog did not halt under -sim $engine"
+		continue
+	    fi
+	    printf "%s\n" ${times[@]} | sort -n | awk -v p=$prog -v e=$engine -v b=$variant -v u=$user '
+		{ ns[NR] = $1 }
+		END {
+		    best = ns[1]; median = ns[int((NR + 1) / 2)]
+		    printf "%-12s %-10s %-9s %12d %8.3f %8.3f %14.0f\n", p, e, b, u, best / 1e9, median / 1e9, u / (best / 1e9)
+		}'
+	done
+    done
+done
+
+exit 0
@@ -94,6 +94,13 @@ class FileSystem {
         if(this->OpenFileTable[id] == NULL) return -1;
         return this->OpenFileTable[id]->Read(buffer, size);
     }
+//  The MapFile function is used for kernel map system call: the mapping
+//  keeps the file open after CloseFile
+    OpenFile *MapFile(OpenFileId id){
+        if(id < 0 || id >= 20) return NULL;
+        if(this->OpenFileTable[id] == NULL) return NULL;
+        return this->OpenFileTable[id]->Reopen();
+    }
     int CloseFile(OpenFileId id){
         // handle invalid file id
         if(id < 0 || id >= 20) return -1;
@@ -53,7 +53,9 @@ class OpenFile {
 		}
 
     int Length() { Lseek(file, 0, 2); return Tell(file); }
-    
+    OpenFile *Reopen() { return new OpenFile(Dup(file)); }
+			// another handle on the same file, which
+			// stays open when this one is closed
   
   private:
     int file;
@@ -24,22 +24,17 @@
 
 Debug::Debug(char *flagList)
 {
-    enableFlags = flagList;
-}
-
-
-//----------------------------------------------------------------------
-// Debug::IsEnabled
-//      Return TRUE if DEBUG messages with "flag" are to be printed.
-//----------------------------------------------------------------------
+    int i;
 
-bool
-Debug::IsEnabled(char flag)
-{
-    if (enableFlags != NULL) {
-	return ((strchr(enableFlags, flag) != 0) 
-		|| (strchr(enableFlags, '+') != 0));
-    } else {
-    	return FALSE;
+    for (i = 0; i < 4; i++)
+	enableMask[i] = 0;
+    if (flagList == NULL)
+	return;
+    if (strchr(flagList, dbgAll) != NULL) {
+	for (i = 0; i < 4; i++)
+	    enableMask[i] = ~0;
+	return;
     }
+    for (; *flagList != '\0'; flagList++)
+	enableMask[(*flagList >> 5) & 3] |= 1U << (*flagList & 31);
 }
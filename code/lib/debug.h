@@ -6,6 +6,12 @@
 //	passed to Nachos (-d).  You are encouraged to add your own
 //	debugging flags.  Please.... 
 //
+//	The simulator tests some flags for every instruction it executes,
+//	so the enabled flags are kept as a bitmask, one bit per character,
+//	and the test is inline.  Compiling with -DNO_DEBUG turns every
+//	DEBUG message, and every IsEnabled test, into dead code, for when
+//	only the speed of the simulation matters.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -36,10 +42,17 @@ class Debug {
   public:
     Debug(char *flagList);
 
-    bool IsEnabled(char flag);
+#ifdef NO_DEBUG
+    bool IsEnabled(char flag) { return FALSE; }
+#else
+    bool IsEnabled(char flag) {		// is "flag" in the flag list?
+	return (enableMask[(flag >> 5) & 3] >> (flag & 31)) & 1;
+    }
+#endif
 
   private:
-    char *enableFlags;		// controls which DEBUG messages are printed
+    unsigned int enableMask[4];	// controls which DEBUG messages are 
+				// printed: one bit per (7-bit) character
 };
 
 extern Debug *debug;
@@ -49,10 +62,17 @@ extern Debug *debug;
 // DEBUG
 //      If flag is enabled, print a message.
 //----------------------------------------------------------------------
+#ifdef NO_DEBUG
+#define DEBUG(flag,expr)                                                     \
+    if (TRUE) {} else { 						\
+        cerr << expr << "\n";   				        \
+    }
+#else
 #define DEBUG(flag,expr)                                                     \
     if (!debug->IsEnabled(flag)) {} else { 				\
         cerr << expr << "\n";   				        \
     }
+#endif
 
 
 //----------------------------------------------------------------------
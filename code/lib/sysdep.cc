@@ -51,9 +51,7 @@ extern "C" {
 #include <signal.h>
 #include <sys/types.h>
 
-#ifndef NO_MPROT 
 #include <sys/mman.h>
-#endif
 
 // UNIX routines called by procedures in this file 
 
@@ -247,6 +245,39 @@ DeallocBoundedArray(char *ptr, int size)
 }
 #endif
 
+//----------------------------------------------------------------------
+// AllocExecutable
+// 	Return an array that host code can be written into and then
+//	executed, for the simulator's code cache.  Unlike the heap, such
+//	memory has to be mapped with execute permission.
+//
+//	"size" -- amount of space needed (in bytes)
+//----------------------------------------------------------------------
+
+char *
+AllocExecutable(int size)
+{
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+		     MAP_PRIVATE | MAP_ANON, -1, 0);
+
+    ASSERT(ptr != MAP_FAILED);
+    return (char *) ptr;
+}
+
+//----------------------------------------------------------------------
+// DeallocExecutable
+// 	Give back an array allocated by AllocExecutable.
+//
+//	"ptr" -- the array to be deallocated
+//	"size" -- its size (in bytes)
+//----------------------------------------------------------------------
+
+void
+DeallocExecutable(char *ptr, int size)
+{
+    munmap(ptr, size);
+}
+
 //----------------------------------------------------------------------
 // PollFile
 // 	Check open file or open socket to see if there are any 
@@ -410,6 +441,20 @@ Close(int fd)
     return retVal;
 }
 
+//----------------------------------------------------------------------
+// Dup
+// 	Return another file descriptor for the open file "fd", which
+//	stays open when "fd" is closed.  Abort on error.
+//----------------------------------------------------------------------
+
+int
+Dup(int fd)
+{
+    int newFd = dup(fd);
+    ASSERT(newFd >= 0);
+    return newFd;
+}
+
 //----------------------------------------------------------------------
 // Unlink
 // 	Delete a file.
@@ -37,6 +37,10 @@ extern unsigned int RandomNumber();
 extern char *AllocBoundedArray(int size);
 extern void DeallocBoundedArray(char *p, int size);
 
+// Allocate, de-allocate memory that can hold host code to be executed
+extern char *AllocExecutable(int size);
+extern void DeallocExecutable(char *p, int size);
+
 // Check file to see if there are any characters to be read.
 // If no characters in the file, return without waiting.
 extern bool PollFile(int fd);
@@ -51,6 +55,7 @@ extern void WriteFile(int fd, char *buffer, int nBytes);
 extern void Lseek(int fd, int offset, int whence);
 extern int Tell(int fd);
 extern int Close(int fd);
+extern int Dup(int fd);
 extern bool Unlink(char *name);
 
 // Other C library routines that are used by Nachos.
@@ -0,0 +1,167 @@
+// trace.cc
+//	Routines to record scheduling events in binary, and to decode
+//	them back into text.  See trace.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "trace.h"
+#include "sysdep.h"
+
+// The trace file starts with this, followed by the size of a record,
+// so that we don't decode a file written by some other build.
+
+const int TraceMagic = 0x4e545243;	// "NTRC"
+
+Trace *trace = NULL;
+
+//----------------------------------------------------------------------
+// Trace::Trace
+// 	Create the trace file, and an empty ring to buffer events in.
+//
+//	"fileName" is the UNIX file to write the events to
+//----------------------------------------------------------------------
+
+Trace::Trace(char *fileName)
+{
+    int header[2];
+
+    fd = OpenForWrite(fileName);
+    header[0] = TraceMagic;
+    header[1] = sizeof(TraceRecord);
+    WriteFile(fd, (char *) header, sizeof(header));
+
+    ring = new TraceRecord[TraceRingSize];
+    head = tail = 0;
+}
+
+//----------------------------------------------------------------------
+// Trace::~Trace
+// 	Write out the events still in the ring, and close the file.
+//----------------------------------------------------------------------
+
+Trace::~Trace()
+{
+    Flush();
+    Close(fd);
+    delete [] ring;
+}
+
+//----------------------------------------------------------------------
+// Trace::Record
+// 	Add an event to the ring, first making room by writing the ring
+//	out, if it is full.
+//
+//	"tick" is when the event happened
+//	"event" is what happened
+//	"thread" is the ID of the thread it happened to
+//	"a0", "a1", "a2" are the event's arguments; see TraceEvent
+//----------------------------------------------------------------------
+
+void
+Trace::Record(int tick, TraceEvent event, int thread,
+	      double a0, double a1, double a2)
+{
+    TraceRecord *rec;
+
+    if ((tail + 1) % TraceRingSize == head)
+	Flush();
+    rec = &ring[tail];
+    rec->tick = tick;
+    rec->event = event;
+    rec->thread = thread;
+    rec->arg[0] = a0;
+    rec->arg[1] = a1;
+    rec->arg[2] = a2;
+    tail = (tail + 1) % TraceRingSize;
+}
+
+//----------------------------------------------------------------------
+// Trace::Flush
+// 	Write the buffered events to the file, oldest first: at most two
+//	writes, one if the events do not wrap around the end of the ring.
+//----------------------------------------------------------------------
+
+void
+Trace::Flush()
+{
+    if (tail < head) {
+	WriteFile(fd, (char *) &ring[head],
+		  (TraceRingSize - head) * sizeof(TraceRecord));
+	head = 0;
+    }
+    if (head < tail)
+	WriteFile(fd, (char *) &ring[head], (tail - head) * sizeof(TraceRecord));
+    head = tail;
+}
+
+//----------------------------------------------------------------------
+// Trace::Print
+// 	Print one event exactly as the "-d z" DEBUG message for it reads.
+//----------------------------------------------------------------------
+
+void
+Trace::Print(int tick, int event, int thread, double a0, double a1, double a2)
+{
+    switch (event) {
+      case TraceInsert:
+	cerr << "[A] Tick [" << tick << "]: Thread [" << thread
+	     << "] is inserted into queue L[" << (int) a0 << "]\n";
+	break;
+      case TraceRemove:
+	cerr << "[B] Tick [" << tick << "]: Thread [" << thread
+	     << "] is removed from queue L[" << (int) a0 << "]\n";
+	break;
+      case TraceBurst:
+	cerr << "[D] Tick [" << tick << "]: Thread [" << thread
+	     << "] update approximate burst time, from: [" << a0
+	     << "], add [" << (int) a1 << "] to [" << a2 << "]\n";
+	break;
+      case TraceSwitch:
+	cerr << "[E] Tick [" << tick << "]: Thread [" << thread
+	     << "] is now selected for execution, thread [" << (int) a0
+	     << "] is replaced, and it has executed [" << (int) a1
+	     << "] ticks\n";
+	break;
+      default:
+	cerr << "Unknown trace event " << event << " at tick " << tick << "\n";
+	break;
+    }
+}
+
+//----------------------------------------------------------------------
+// Trace::Decode
+// 	Print every event in a trace file, as text.
+//
+//	"fileName" is the UNIX file the events were written to
+//----------------------------------------------------------------------
+
+void
+Trace::Decode(char *fileName)
+{
+    int header[2];
+    TraceRecord *recs = new TraceRecord[TraceRingSize];
+    int fd, n;
+
+    fd = OpenForReadWrite(fileName, FALSE);
+    if (fd < 0) {
+	cerr << "Unable to open trace file " << fileName << "\n";
+	delete [] recs;
+	return;
+    }
+    if (ReadPartial(fd, (char *) header, sizeof(header)) != sizeof(header)
+	  || header[0] != TraceMagic || header[1] != sizeof(TraceRecord)) {
+	cerr << fileName << " is not a Nachos trace file\n";
+    } else {
+	while ((n = ReadPartial(fd, (char *) recs,
+				TraceRingSize * sizeof(TraceRecord))) > 0) {
+	    for (int i = 0; i < n / (int) sizeof(TraceRecord); i++)
+		Print(recs[i].tick, recs[i].event, recs[i].thread,
+		      recs[i].arg[0], recs[i].arg[1], recs[i].arg[2]);
+	}
+    }
+    Close(fd);
+    delete [] recs;
+}
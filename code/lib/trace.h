@@ -0,0 +1,90 @@
+// trace.h
+//	Data structures for recording scheduling events in binary.
+//
+//	The scheduler's "-d z" messages ([A] through [E]) are what we
+//	analyze its behavior with, but formatting each of them through
+//	cerr as it happens costs far more than the event itself, and
+//	changes the very timing we are trying to observe.
+//
+//	With "-trace <file>", each event is instead stored as a fixed-size
+//	binary record in a ring buffer in memory.  Records are only written
+//	out, in bulk, when the ring fills up, when the machine goes idle,
+//	and when Nachos halts.  "nachos -dt <file>" later decodes the file
+//	into the same text the "-d z" messages print.
+//
+//	Nachos runs on a single host thread, so the producer (the kernel)
+//	and the consumer (Flush) never run at the same time, and the ring
+//	needs no locks.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "debug.h"
+
+// The events we trace, and what their arguments are.
+
+enum TraceEvent {
+    TraceInsert = 'A',		// thread inserted into queue: level
+    TraceRemove = 'B',		// thread removed from queue: level
+    TraceBurst = 'D',		// burst time updated: old estimate, ticks
+				// just run, new estimate
+    TraceSwitch = 'E'		// thread selected to run: the thread it
+				// replaces, how long that one ran
+};
+
+// One event, as stored in the ring and in the trace file.
+
+struct TraceRecord {
+    int tick;			// kernel->stats->GlobalTicks()
+    short event;		// a TraceEvent
+    short thread;		// ID of the thread the event is about
+    double arg[3];		// event-specific arguments
+};
+
+const int TraceRingSize = 4096;		// # of records buffered in memory
+
+class Trace {
+  public:
+    Trace(char *fileName);		// Record events into "fileName"
+    ~Trace();				// Write out any records left
+
+    void Record(int tick, TraceEvent event, int thread,
+		double a0 = 0, double a1 = 0, double a2 = 0);
+					// Buffer one event
+    void Flush();			// Write out the buffered events
+
+    static void Print(int tick, int event, int thread,
+		      double a0, double a1, double a2);
+					// Print an event as text on cerr
+    static void Decode(char *fileName);	// Print a whole trace file as text
+
+  private:
+    TraceRecord *ring;			// buffered events
+    int head;				// next record to write out
+    int tail;				// next free record; the ring is empty
+					// when head == tail
+    int fd;				// the trace file
+};
+
+extern Trace *trace;			// NULL unless we are tracing
+
+//----------------------------------------------------------------------
+// TRACE
+//      Record a scheduling event, if we are tracing, or else print it
+//	like a DEBUG message, if "-d z" asks for that.
+//----------------------------------------------------------------------
+
+#define TRACE(tick,event,thread,a0,a1,a2)				\
+    if (trace != NULL) {						\
+	trace->Record(tick, event, thread, a0, a1, a2);			\
+    } else if (debug->IsEnabled(dbgQLevel)) {				\
+	Trace::Print(tick, event, thread, a0, a1, a2);			\
+    }
+
+#endif // TRACE_H
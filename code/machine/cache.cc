@@ -0,0 +1,113 @@
+// cache.cc
+//	Routines to simulate the timing of a set-associative cache.
+//
+//	See cache.h for what is (and is not) simulated.  The cost of a
+//	reference is counted in ticks:
+//
+//		hit			0
+//		miss			CacheMissTicks, to read the line,
+//					plus CacheMissTicks more if a dirty
+//					line has to be written back first
+//		write-through store	CacheWriteTicks, hit or miss
+
+#include "copyright.h"
+#include "cache.h"
+#include "debug.h"
+#include "stats.h"
+
+//----------------------------------------------------------------------
+// Cache::Cache
+// 	Initialize an empty cache.
+//
+//	"lineSize" -- the number of bytes in each line
+//	"sets" -- the number of sets
+//	"ways" -- the number of lines in each set; 1 for a direct-mapped
+//		cache
+//	"policy" -- what to do on a store
+//----------------------------------------------------------------------
+
+Cache::Cache(int lineSize, int sets, int ways, CacheWritePolicy policy)
+{
+    ASSERT(lineSize > 0 && sets > 0 && ways > 0);
+
+    this->lineSize = lineSize;
+    numSets = sets;
+    numWays = ways;
+    this->policy = policy;
+    tag = new int[sets * ways];
+    valid = new bool[sets * ways];
+    dirty = new bool[sets * ways];
+    lastUsed = new int[sets * ways];
+    for (int i = 0; i < sets * ways; i++) {
+	valid[i] = dirty[i] = FALSE;
+	lastUsed[i] = 0;
+    }
+    references = 0;
+}
+
+//----------------------------------------------------------------------
+// Cache::~Cache
+// 	De-allocate the cache.
+//----------------------------------------------------------------------
+
+Cache::~Cache()
+{
+    delete [] tag;
+    delete [] valid;
+    delete [] dirty;
+    delete [] lastUsed;
+}
+
+//----------------------------------------------------------------------
+// Cache::Access
+// 	Simulate a reference to the byte (or word) at "physAddr", and
+//	return the number of ticks it stalls the processor for.
+//
+//	"physAddr" -- the physical address referenced
+//	"writing" -- TRUE for a store
+//	"hit" -- set to TRUE if the line was in the cache
+//----------------------------------------------------------------------
+
+int
+Cache::Access(int physAddr, bool writing, bool *hit)
+{
+    int line = physAddr / lineSize;
+    int first = (line % numSets) * numWays;
+    int victim = first;
+    int stall = 0;
+    int i;
+
+    references++;
+    for (i = first; i < first + numWays; i++)
+	if (valid[i] && tag[i] == line / numSets)
+	    break;
+
+    *hit = (i < first + numWays);
+    if (writing && policy == WriteThrough) {
+	if (*hit)
+	    lastUsed[i] = references;
+	return CacheWriteTicks;		// nothing allocated on a miss
+    }
+
+    if (!*hit) {
+	for (i = first; i < first + numWays; i++) {
+	    if (!valid[i]) {		// an empty line: use it
+		victim = i;
+		break;
+	    }
+	    if (lastUsed[i] < lastUsed[victim])
+		victim = i;
+	}
+	i = victim;
+	if (valid[i] && dirty[i])
+	    stall += CacheMissTicks;	// write the old line back
+	stall += CacheMissTicks;	// and read in the new one
+	tag[i] = line / numSets;
+	valid[i] = TRUE;
+	dirty[i] = FALSE;
+    }
+    lastUsed[i] = references;
+    if (writing)
+	dirty[i] = TRUE;
+    return stall;
+}
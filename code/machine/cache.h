@@ -0,0 +1,56 @@
+// cache.h
+//	Data structures to simulate the timing of a processor cache.
+//
+//	A Cache only keeps the tags of the lines it holds: the data itself
+//	always stays in the Machine's mainMemory, so turning a cache on or
+//	off never changes what a user program computes, only how many
+//	ticks its memory references cost.  Caches are indexed by physical
+//	address, and replace the least recently used line of a set.
+//
+//	The Machine has an optional instruction cache, consulted on every
+//	instruction fetch, and an optional data cache, consulted by every
+//	load and store (see Machine::CacheReference).
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// What a store does to the cache.
+
+enum CacheWritePolicy { WriteBack,	// write the line when it is evicted;
+					// allocate a line on a write miss
+			WriteThrough	// write every store to memory; never
+					// allocate a line on a write miss
+};
+
+class Cache {
+  public:
+    Cache(int lineSize, int sets, int ways, CacheWritePolicy policy);
+					// A cache of "sets" * "ways" lines
+					// of "lineSize" bytes each; starts
+					// out empty
+    ~Cache();
+
+    int Access(int physAddr, bool writing, bool *hit);
+					// Reference "physAddr", and return
+					// the # of ticks the reference
+					// stalls; set "hit" if the line was
+					// already in the cache
+
+  private:
+    int lineSize;			// bytes per line
+    int numSets;
+    int numWays;			// lines per set
+    CacheWritePolicy policy;
+
+    // Per line, "numWays" consecutive entries for each set
+    int *tag;				// line address / numSets
+    bool *valid;
+    bool *dirty;			// written, not yet back in memory
+    int *lastUsed;			// when it was last referenced
+    int references;			// # of calls to Access so far
+};
+
+#endif // CACHE_H
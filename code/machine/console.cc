@@ -15,6 +15,7 @@
 #include "copyright.h"
 #include "console.h"
 #include "main.h"
+#include "eventlog.h"
 #include "stdio.h"
 //----------------------------------------------------------------------
 // ConsoleInput::ConsoleInput
@@ -57,7 +58,8 @@ ConsoleInput::~ConsoleInput()
 // 	Simulator calls this when a character may be available to be
 //	read in from the simulated keyboard (eg, the user typed something).
 //
-//	First check to make sure character is available.
+//	First check to make sure character is available (or, when
+//	replaying, whether the event log has one for us by now).
 //	Then invoke the "callBack" registered by whoever wants the character.
 //----------------------------------------------------------------------
 
@@ -66,14 +68,25 @@ ConsoleInput::CallBack()
 {
   char c;
   int readCount;
+  EventLog *log = kernel->eventLog;
 
     ASSERT(incoming == EOF);
-    if (!PollFile(readFileNo)) { // nothing to be read
+    if (log != NULL && log->IsReplaying()) {	// the log says what we read
+	readCount = log->Replay(LogConsole, kernel->stats->totalTicks, &c);
+    } else if (!PollFile(readFileNo)) {
+	readCount = -1;
+    } else {
+    	// otherwise, try to read a character
+    	readCount = ReadPartial(readFileNo, &c, sizeof(char));
+	// log a character, or the end of the file (no data); a failed
+	// read is just no character yet, as below, and is not logged
+	if (log != NULL && readCount >= 0)
+	    log->Record(LogConsole, kernel->stats->totalTicks, &c, readCount);
+    }
+    if (readCount < 0) { // nothing to be read
         // schedule the next time to poll for a packet
         kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
     } else { 
-    	// otherwise, try to read a character
-    	readCount = ReadPartial(readFileNo, &c, sizeof(char));
 	if (readCount == 0) {
 	   // this seems to happen at end of file, when the
 	   // console input is a regular file
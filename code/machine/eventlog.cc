@@ -0,0 +1,148 @@
+// eventlog.cc
+//	Routines to record the events that come into the simulation from
+//	the host, and to replay them.  See eventlog.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "eventlog.h"
+#include "debug.h"
+#include "sysdep.h"
+
+// The log starts with this, followed by the size of a record, so that
+// we don't replay a file written by some other build.
+
+const int EventLogMagic = 0x4e45564c;	// "NEVL"
+
+//----------------------------------------------------------------------
+// EventLog::EventLog
+// 	Create the log, or read in all of a log to replay.
+//
+//	"fileName" is the UNIX file the events go in, or come from
+//	"replay" is TRUE if we are to replay them
+//----------------------------------------------------------------------
+
+EventLog::EventLog(char *fileName, bool replay)
+{
+    int header[2];
+
+    replaying = replay;
+    if (!replaying) {
+	fd = OpenForWrite(fileName);
+	header[0] = EventLogMagic;
+	header[1] = sizeof(EventRecord);
+	WriteFile(fd, (char *) header, sizeof(header));
+	buffer = new char[EventLogBufferSize];
+	size = 0;
+	return;
+    }
+
+    fd = OpenForReadWrite(fileName, FALSE);
+    if (fd < 0) {
+	cerr << "Unable to open event log " << fileName << "\n";
+	Abort();
+    }
+    if (ReadPartial(fd, (char *) header, sizeof(header)) != sizeof(header)
+	  || header[0] != EventLogMagic || header[1] != sizeof(EventRecord)) {
+	cerr << fileName << " is not a Nachos event log\n";
+	Abort();
+    }
+    Lseek(fd, 0, 2);
+    size = Tell(fd) - sizeof(header);
+    Lseek(fd, sizeof(header), 0);
+    buffer = new char[size];
+    Read(fd, buffer, size);
+    Close(fd);
+    fd = -1;
+    for (int i = 0; i < NumLoggedEvents; i++)
+	next[i] = 0;
+}
+
+//----------------------------------------------------------------------
+// EventLog::~EventLog
+// 	Write out the events still buffered, if we are recording.
+//----------------------------------------------------------------------
+
+EventLog::~EventLog()
+{
+    if (!replaying) {
+	Flush();
+	Close(fd);
+    }
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// EventLog::Record
+// 	Add an event to the buffer, first making room by writing the
+//	buffer out, if it is full.
+//
+//	"event" is what happened, at "tick"
+//	"data", "length" is what it brought in from the host
+//----------------------------------------------------------------------
+
+void
+EventLog::Record(LoggedEvent event, int tick, char *data, int length)
+{
+    EventRecord rec;
+
+    ASSERT(!replaying && length >= 0
+	   && length <= EventLogBufferSize - (int) sizeof(rec));
+    if (size + (int) sizeof(rec) + length > EventLogBufferSize)
+	Flush();
+    rec.tick = tick;
+    rec.event = event;
+    rec.length = length;
+    bcopy((char *) &rec, buffer + size, sizeof(rec));
+    bcopy(data, buffer + size + sizeof(rec), length);
+    size += sizeof(rec) + length;
+}
+
+//----------------------------------------------------------------------
+// EventLog::Flush
+// 	Write the buffered events to the log.
+//----------------------------------------------------------------------
+
+void
+EventLog::Flush()
+{
+    if (!replaying && size > 0) {
+	WriteFile(fd, buffer, size);
+	size = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// EventLog::Replay
+// 	Find the next event of the kind "event" in the log.  If it
+//	happened at or before "tick", consume it: copy its data into
+//	"data", and return its length.  Otherwise, or if there are none
+//	left, return -1.
+//
+//	Each kind of event has its own place in the log, so that looking
+//	for one is not thrown off by the others.
+//----------------------------------------------------------------------
+
+int
+EventLog::Replay(LoggedEvent event, int tick, char *data)
+{
+    EventRecord rec;
+    int pos = next[event];
+
+    ASSERT(replaying);
+    while (pos + (int) sizeof(rec) <= size) {
+	bcopy(buffer + pos, (char *) &rec, sizeof(rec));
+	if (rec.event == event)
+	    break;
+	pos += sizeof(rec) + rec.length;
+    }
+    next[event] = pos;
+    if (pos + (int) sizeof(rec) > size || rec.tick > tick)
+	return -1;
+
+    bcopy(buffer + pos + sizeof(rec), data, rec.length);
+    next[event] = pos + sizeof(rec) + rec.length;
+    return rec.length;
+}
@@ -0,0 +1,79 @@
+// eventlog.h
+//	Data structures to record the events that come into the simulation
+//	from outside of it, and to replay them in a later run.
+//
+//	Everything Nachos simulates is deterministic, except for what it
+//	takes from the host: when console input is available (and what
+//	it is), when network packets arrive, and the random time slices
+//	of "-rs".  With "-record <file>", each of these is logged, with
+//	the tick it happened at; with "-replay <file>", the devices take
+//	them from the log instead of from the host, so that a second run
+//	of the same workload sees exactly the same inputs at the same
+//	ticks, and ends with the same statistics.
+//
+//	A console character or packet is handed to the device at the
+//	first poll at or after the tick it was logged at.  Timer delays
+//	are logged at tick 0: they are replayed in order, whenever the
+//	timer asks for one.
+//
+//	The log is a header (magic number, size of an EventRecord),
+//	followed by one EventRecord per event, each followed by its
+//	"length" bytes of data.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The kinds of events we log, and their data.
+
+enum LoggedEvent {
+    LogConsole,			// console input polled: the character,
+				// or no data at end of file
+    LogNetwork,			// packet arrived: header and contents
+    LogTimer,			// random timer delay: an int
+    NumLoggedEvents
+};
+
+struct EventRecord {
+    int tick;			// when the event happened
+    short event;		// a LoggedEvent
+    short length;		// # of bytes of data that follow
+};
+
+const int EventLogBufferSize = 65536;	// bytes buffered before writing
+
+class EventLog {
+  public:
+    EventLog(char *fileName, bool replay);
+				// Record events into "fileName", or
+				// replay the ones recorded in it
+    ~EventLog();		// Write out any events left
+
+    bool IsReplaying() { return replaying; }
+
+    void Record(LoggedEvent event, int tick, char *data, int length);
+				// Log an event
+    int Replay(LoggedEvent event, int tick, char *data);
+				// Copy the data of the next logged event
+				// of this kind into "data", and return
+				// its length, if it happened by "tick";
+				// otherwise return -1
+    void Flush();		// Write out the buffered events
+
+  private:
+    bool replaying;
+    int fd;			// the log, when recording
+    char *buffer;		// recording: events not yet written;
+				// replaying: the whole log
+    int size;			// # of bytes in buffer
+    int next[NumLoggedEvents];	// replaying: where to look for the next
+				// event of each kind
+};
+
+#endif // EVENTLOG_H
@@ -23,6 +23,8 @@
 #include "copyright.h"
 #include "interrupt.h"
 #include "main.h"
+#include "trace.h"
+#include "eventlog.h"
 
 // String definitions for debugging messages
 
@@ -39,14 +41,16 @@ static char *intTypeNames[] = { "timer", "disk", "console write",
 //	"callOnInt" is the object to call when the interrupt occurs
 //	"time" is when (in simulated time) the interrupt is to occur
 //	"kind" is the hardware device that generated the interrupt
+//	"cpuNum" is the CPU to interrupt, or AnyCpu
 //----------------------------------------------------------------------
 
 PendingInterrupt::PendingInterrupt(CallBackObj *callOnInt, 
-					int time, IntType kind)
+					int time, IntType kind, int cpuNum)
 {
     callOnInterrupt = callOnInt;
     when = time;
     type = kind;
+    cpu = cpuNum;
 }
 
 //----------------------------------------------------------------------
@@ -96,7 +100,7 @@ Interrupt::~Interrupt()
 // 	Change interrupts to be enabled or disabled, without advancing 
 //	the simulated time (normally, enabling interrupts advances the time).
 //
-//	Used internally.
+//	Used internally, and when switching between simulated CPUs.
 //
 //	"old" -- the old interrupt status
 //	"now" -- the new interrupt status
@@ -166,15 +170,125 @@ Interrupt::OneTick()
 				// interrupts disabled)
     CheckIfDue(FALSE);		// check for pending interrupts
     ChangeLevel(IntOff, IntOn);	// re-enable interrupts
+    if (oldStatus == UserMode && kernel->checkpointFile != NULL
+	  && stats->totalTicks >= kernel->checkpointTick
+	  && stats->totalTicks % TimerTicks == 0)
+	(void) kernel->Checkpoint();	// between two user instructions we
+					// can take a checkpoint; try once in
+					// a while, as it is not cheap
     if (yieldOnReturn) {	// if the timer device handler asked 
     				// for a context switch, ok to do it now
 	yieldOnReturn = FALSE;
  	status = SystemMode;		// yield is a kernel routine
+	kernel->currentThread->preemptedInUserMode = (oldStatus == UserMode);
 	kernel->currentThread->Yield();
+	kernel->currentThread->preemptedInUserMode = FALSE;
 	status = oldStatus;
     }
 }
 
+//----------------------------------------------------------------------
+// Interrupt::NextInterruptTime
+// 	Return the simulated time at which the first pending interrupt
+//	is due, or -1 if there are no pending interrupts.
+//
+//	Until that time, OneTick only advances the clock; the simulator
+//	uses this to skip the interrupt check for a run of instructions.
+//----------------------------------------------------------------------
+
+int
+Interrupt::NextInterruptTime()
+{
+    PendingInterrupt *next = FirstPending();
+
+    if (next == NULL)
+	return -1;
+    return next->when;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::FirstPending
+// 	Return the earliest pending interrupt that the CPU being simulated
+//	can take -- one for any CPU, or for this one in particular -- or
+//	NULL if there is none.  With a single CPU, that is always the
+//	front of the list.
+//----------------------------------------------------------------------
+
+PendingInterrupt *
+Interrupt::FirstPending()
+{
+    ListIterator<PendingInterrupt *> iter(pending);
+
+    for (; !iter.IsDone(); iter.Next()) {
+	if (iter.Item()->cpu == AnyCpu
+	      || iter.Item()->cpu == kernel->currentCpu)
+	    return iter.Item();
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Checkpoint, Interrupt::Restore
+// 	Save the pending interrupts to the UNIX file "fd", for
+//	Kernel::Checkpoint -- each one's device, CPU and due time -- or
+//	load them back, for Kernel::Restore.
+//
+//	We can't save the objects to call back, but we don't need to: by
+//	the time we restore, the devices have scheduled their interrupts
+//	again (the timer, the console polling for input), so each saved
+//	interrupt moves the first new one of the same device and CPU to
+//	its saved time.  A new one with nothing saved for it stays, and
+//	is taken at once.  Disk and console output interrupts, which
+//	only a blocked thread waits for, are never pending at a
+//	checkpoint.
+//----------------------------------------------------------------------
+
+void
+Interrupt::Checkpoint(int fd)
+{
+    ListIterator<PendingInterrupt *> iter(pending);
+    int n = pending->NumInList(), saved[3];
+
+    ::WriteFile(fd, (char *) &n, sizeof(int));
+    for (; !iter.IsDone(); iter.Next()) {
+	saved[0] = iter.Item()->type;
+	saved[1] = iter.Item()->cpu;
+	saved[2] = iter.Item()->when;
+	::WriteFile(fd, (char *) saved, sizeof(saved));
+    }
+}
+
+void
+Interrupt::Restore(int fd)
+{
+    List<PendingInterrupt *> *ours = new List<PendingInterrupt *>;
+    PendingInterrupt *toMove;
+    int n, saved[3];
+
+    while (!pending->IsEmpty())
+	ours->Append(pending->RemoveFront());
+    Read(fd, (char *) &n, sizeof(int));
+    for (int i = 0; i < n; i++) {
+	Read(fd, (char *) saved, sizeof(saved));
+	toMove = NULL;
+	ListIterator<PendingInterrupt *> iter(ours);
+	for (; !iter.IsDone() && toMove == NULL; iter.Next()) {
+	    if (iter.Item()->type == saved[0] && iter.Item()->cpu == saved[1])
+		toMove = iter.Item();
+	}
+	if (toMove == NULL) {
+	    DEBUG(dbgInt, "Nothing to restore the " << intTypeNames[saved[0]] << " interrupt at time = " << saved[2] << " to");
+	    continue;
+	}
+	ours->Remove(toMove);
+	toMove->when = saved[2];
+	pending->Insert(toMove);
+    }
+    while (!ours->IsEmpty())
+	pending->Insert(ours->RemoveFront());
+    delete ours;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::YieldOnReturn
 // 	Called from within an interrupt handler, to cause a context switch
@@ -209,6 +323,12 @@ Interrupt::Idle()
 {
     DEBUG(dbgInt, "Machine idling; checking for interrupts.");
     status = IdleMode;
+    if (trace != NULL) {	// a good time to write out the events
+	trace->Flush();		// we have traced so far
+    }
+    if (kernel->eventLog != NULL) {	// and the ones we have logged
+	kernel->eventLog->Flush();
+    }
 	DEBUG(dbgTraCode, "In Interrupt::Idle, into CheckIfDue, " << kernel->stats->totalTicks);
     if (CheckIfDue(TRUE)) {	// check for any pending interrupts
 	DEBUG(dbgTraCode, "In Interrupt::Idle, return true from CheckIfDue, " << kernel->stats->totalTicks);
@@ -239,6 +359,11 @@ Interrupt::Halt()
     cout << "Machine halting!\n\n";
     cout << "This is halt\n";
     kernel->stats->Print();
+    if (kernel->numCpus > 1) {
+	kernel->cpu[kernel->currentCpu]->clock = kernel->stats->totalTicks;
+	for (int i = 0; i < kernel->numCpus; i++)
+	    kernel->cpu[i]->Print();
+    }
     delete kernel;	// Never returns.
 }
 /*
@@ -293,12 +418,14 @@ Interrupt::CloseFile(OpenFileId id)
 //	"fromNow" is how far in the future (in simulated time) the 
 //		 interrupt is to occur
 //	"type" is the hardware device that generated the interrupt
+//	"cpu" is the CPU to interrupt; by default, whichever CPU gets
+//		there first
 //----------------------------------------------------------------------
 void
-Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type)
+Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type, int cpu)
 {
     int when = kernel->stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(toCall, when, type);
+    PendingInterrupt *toOccur = new PendingInterrupt(toCall, when, type, cpu);
 
     DEBUG(dbgInt, "Scheduling interrupt handler the " << intTypeNames[type] << " at time = " << when);
     ASSERT(fromNow > 0);
@@ -329,10 +456,10 @@ Interrupt::CheckIfDue(bool advanceClock)
     if (debug->IsEnabled(dbgInt)) {
 	DumpState();
     }
-    if (pending->IsEmpty()) {   	// no pending interrupts
+    next = FirstPending();
+    if (next == NULL) {   	// no pending interrupts
 	return FALSE;	
     }		
-    next = pending->Front();
 
     if (next->when > stats->totalTicks) {
         if (!advanceClock) {		// not time yet
@@ -354,13 +481,13 @@ Interrupt::CheckIfDue(bool advanceClock)
 
     inHandler = TRUE;
     do {
-        next = pending->RemoveFront();    // pull interrupt off list
+        pending->Remove(next);    	// pull interrupt off list
 		DEBUG(dbgTraCode, "In Interrupt::CheckIfDue, into callOnInterrupt->CallBack, " << stats->totalTicks);
         next->callOnInterrupt->CallBack();// call the interrupt handler
 		DEBUG(dbgTraCode, "In Interrupt::CheckIfDue, return from callOnInterrupt->CallBack, " << stats->totalTicks);
 	delete next;
-    } while (!pending->IsEmpty() 
-    		&& (pending->Front()->when <= stats->totalTicks));
+        next = FirstPending();
+    } while (next != NULL && (next->when <= stats->totalTicks));
     inHandler = FALSE;
     return TRUE;
 }
@@ -51,6 +51,12 @@ enum MachineStatus {IdleMode, SystemMode, UserMode};
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
 			NetworkSendInt, NetworkRecvInt};
 
+// With several simulated CPUs (see cpu.h), an interrupt is either taken
+// by a particular CPU -- each CPU's timer interrupts only that CPU -- or
+// by whichever CPU gets to it first.
+
+#define AnyCpu		-1
+
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
 // left public to make it simpler to manipulate.
@@ -59,7 +65,8 @@ typedef int OpenFileId;
 
 class PendingInterrupt {
   public:
-    PendingInterrupt(CallBackObj *callOnInt, int time, IntType kind);
+    PendingInterrupt(CallBackObj *callOnInt, int time, IntType kind,
+		     int cpuNum);
 				// initialize an interrupt that will
 				// occur in the future
 
@@ -68,6 +75,7 @@ class PendingInterrupt {
     
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+    int cpu;			// the CPU to interrupt, or AnyCpu
 };
 
 // The following class defines the data structures for the simulation
@@ -119,13 +127,25 @@ class Interrupt {
     // but they need to be public since they are called by the
     // hardware device simulators.
 
-    void Schedule(CallBackObj *callTo, int when, IntType type);
+    void Schedule(CallBackObj *callTo, int when, IntType type,
+		  int cpu = AnyCpu);
     				// Schedule an interrupt to occur
 				// at time "when".  This is called
     				// by the hardware device simulators.
     
     void OneTick();       	// Advance simulated time
 
+    int NextInterruptTime();	// When the earliest pending interrupt
+				// is due, or -1 if none is pending.
+				// Lets the simulator run ahead safely
+				// up to that time.
+
+    void Checkpoint(int fd);	// Save when the pending interrupts are
+    void Restore(int fd);	// due, or move ours to those times
+    void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
+			IntStatus now); // simulated time; also used to
+				// switch between simulated CPUs
+
   private:
     IntStatus level;		// are interrupts enabled or disabled?
     SortedList<PendingInterrupt *> *pending;		
@@ -145,8 +165,9 @@ class Interrupt {
     				// Check if any interrupts are supposed
 				// to occur now, and if so, do them
 
-    void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
-			IntStatus now); // simulated time
+    PendingInterrupt *FirstPending();
+				// The earliest pending interrupt that
+				// the current CPU can take, if any
 };
 
 #endif // INTERRRUPT_H
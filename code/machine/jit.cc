@@ -0,0 +1,428 @@
+// jit.cc
+//	Routines to translate runs of MIPS ALU instructions into x86 code,
+//	and to run them on behalf of the threaded engine.
+//
+//	A compiled run is a plain function with no arguments:
+//
+//		push %ebx		(%rbx on x86-64)
+//		mov  $registers, %ebx
+//		...			one short sequence per instruction,
+//					using %eax, %ecx and %edx as scratch
+//		pop  %ebx
+//		ret
+//
+//	Every simulated register lives in memory, at a small offset from
+//	%ebx, so the code never has to know how the run was entered or
+//	left.  The caller (Machine::RunJitBlock) takes care of the PC,
+//	the delayed load registers and the simulated time, exactly as if
+//	the run had been interpreted one instruction at a time.
+
+#include "copyright.h"
+#include "jit.h"
+#include "machine.h"
+#include "mipssim.h"
+#include "main.h"
+
+// x86 register numbers, as encoded in the ModRM byte
+#define EAX	0
+#define ECX	1
+
+// Largest sequence EmitInstruction generates for one instruction,
+// and the size of the prologue and epilogue.
+const int MaxBytesPerInstruction = 20;
+const int MaxBytesPerRun = 16;
+
+//----------------------------------------------------------------------
+// Jit::Jit
+// 	Initialize an empty code cache.
+//
+//	"regs" -- the simulated register file; compiled code reads and
+//		writes it directly
+//	"slots" -- # of words of physical memory a run can start at
+//----------------------------------------------------------------------
+
+Jit::Jit(int *regs, int slots)
+{
+    registers = regs;
+    numSlots = slots;
+    entry = new HostCode[numSlots];
+    length = new char[numSlots];
+    heat = new unsigned char[numSlots];
+    cache = AllocExecutable(JitCacheSize);
+    Flush();
+}
+
+//----------------------------------------------------------------------
+// Jit::~Jit
+// 	De-allocate the code cache.
+//----------------------------------------------------------------------
+
+Jit::~Jit()
+{
+    DeallocExecutable(cache, JitCacheSize);
+    delete [] entry;
+    delete [] length;
+    delete [] heat;
+}
+
+//----------------------------------------------------------------------
+// Jit::Flush
+// 	Throw away every compiled run, so the code cache can be refilled.
+//----------------------------------------------------------------------
+
+void
+Jit::Flush()
+{
+    DEBUG(dbgMach, "Flushing the code cache");
+    Invalidate(0, numSlots);
+    cacheUsed = 0;
+}
+
+//----------------------------------------------------------------------
+// Jit::Invalidate
+// 	Forget the runs starting at a range of slots, because the memory
+//	they were compiled from has changed.  Their code stays in the
+//	cache (unreachable) until the next Flush.
+//
+//	"firstSlot" -- the first slot to forget
+//	"count" -- how many slots
+//----------------------------------------------------------------------
+
+void
+Jit::Invalidate(int firstSlot, int count)
+{
+    ASSERT((firstSlot >= 0) && (firstSlot + count <= numSlots));
+    for (int i = firstSlot; i < firstSlot + count; i++) {
+	entry[i] = NULL;
+	length[i] = 0;
+	heat[i] = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// Jit::IsHot
+// 	Count a visit to a slot that has no compiled run yet, and
+//	return TRUE once it has been visited often enough to compile.
+//----------------------------------------------------------------------
+
+bool
+Jit::IsHot(int slot)
+{
+    if (heat[slot] < JitThreshold)
+	heat[slot]++;
+    return (heat[slot] >= JitThreshold);
+}
+
+//----------------------------------------------------------------------
+// Jit::CanCompile
+// 	Return TRUE if "instr" only reads and writes the general purpose
+//	registers, and cannot raise an exception or change the PC.
+//----------------------------------------------------------------------
+
+bool
+Jit::CanCompile(Instruction *instr)
+{
+#ifdef x86
+    switch (instr->opCode) {
+      case OP_ADDIU: case OP_ADDU: case OP_SUBU:
+      case OP_AND: case OP_ANDI: case OP_OR: case OP_ORI:
+      case OP_XOR: case OP_XORI: case OP_NOR: case OP_LUI:
+      case OP_SLL: case OP_SLLV: case OP_SRA: case OP_SRAV:
+      case OP_SRL: case OP_SRLV:
+      case OP_SLT: case OP_SLTI: case OP_SLTIU: case OP_SLTU:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+#else
+    return FALSE;		// we only know how to generate x86 code
+#endif
+}
+
+//----------------------------------------------------------------------
+// Jit::Compile
+// 	Compile a run of instructions, all of which satisfy CanCompile,
+//	and record it as the run starting at "slot".  Runs of a single
+//	instruction gain nothing, and are just marked as not worth it.
+//
+//	"slot" -- where the run starts in physical memory
+//	"instrs" -- the predecoded instructions of the run
+//	"count" -- how many of them
+//----------------------------------------------------------------------
+
+void
+Jit::Compile(int slot, Instruction *instrs, int count)
+{
+    if (count < 2) {
+	length[slot] = -1;
+	return;
+    }
+    ASSERT(count <= 127);	// must fit in length[]
+    if (cacheUsed + count * MaxBytesPerInstruction + MaxBytesPerRun
+	    > JitCacheSize)
+	Flush();
+
+    emit = cache + cacheUsed;
+    entry[slot] = (HostCode) emit;
+
+    EmitByte(0x53);				// push %ebx
+    if (sizeof(int *) == 8)			// mov $registers, %ebx
+	EmitByte(0x48);				// (REX.W: 64-bit immediate)
+    EmitByte(0xbb);
+    bcopy(&registers, emit, sizeof(int *));
+    emit += sizeof(int *);
+
+    for (int i = 0; i < count; i++)
+	EmitInstruction(&instrs[i]);
+
+    EmitByte(0x5b);				// pop %ebx
+    EmitByte(0xc3);				// ret
+
+    DEBUG(dbgMach, "Compiled " << count << " instructions at "
+	  << slot * 4 << " into " << (emit - (cache + cacheUsed)) << " bytes");
+    length[slot] = count;
+    cacheUsed = emit - cache;
+}
+
+//----------------------------------------------------------------------
+// Jit::EmitByte, Jit::EmitWord
+// 	Append one byte, or one little-endian 32-bit word, to the run
+//	being compiled.
+//----------------------------------------------------------------------
+
+void
+Jit::EmitByte(int byte)
+{
+    *emit++ = (char) byte;
+}
+
+void
+Jit::EmitWord(int word)
+{
+    for (int i = 0; i < 4; i++) {
+	EmitByte(word & 0xff);
+	word >>= 8;
+    }
+}
+
+//----------------------------------------------------------------------
+// Jit::EmitLoad, Jit::EmitStore
+// 	Move a simulated register to or from a host scratch register.
+//	registers[r] is at offset 4*r from %ebx, which fits in the
+//	8-bit displacement for all the general purpose registers.
+//----------------------------------------------------------------------
+
+void
+Jit::EmitLoad(int hostReg, int mipsReg)
+{
+    EmitByte(0x8b);				// mov 4*r(%ebx), %reg
+    EmitByte(0x43 | (hostReg << 3));
+    EmitByte(mipsReg * 4);
+}
+
+void
+Jit::EmitStore(int mipsReg, int hostReg)
+{
+    EmitByte(0x89);				// mov %reg, 4*r(%ebx)
+    EmitByte(0x43 | (hostReg << 3));
+    EmitByte(mipsReg * 4);
+}
+
+//----------------------------------------------------------------------
+// Jit::EmitInstruction
+// 	Generate the code for one instruction, with the same effect on
+//	the registers as Machine::OneInstruction.  A write to R0 is
+//	simply dropped, since OneInstruction clears R0 right after.
+//----------------------------------------------------------------------
+
+void
+Jit::EmitInstruction(Instruction *instr)
+{
+    int rs = instr->rs;
+    int rt = instr->rt;
+    int rd = instr->rd;
+
+    switch (instr->opCode) {
+      case OP_ADDU: case OP_SUBU: case OP_AND:
+      case OP_OR: case OP_XOR: case OP_NOR:
+	if (rd == 0)
+	    return;
+	EmitLoad(EAX, rs);
+	EmitLoad(ECX, rt);
+	switch (instr->opCode) {
+	  case OP_ADDU: EmitByte(0x01); break;	// add %ecx, %eax
+	  case OP_SUBU: EmitByte(0x29); break;	// sub %ecx, %eax
+	  case OP_AND: EmitByte(0x21); break;	// and %ecx, %eax
+	  case OP_XOR: EmitByte(0x31); break;	// xor %ecx, %eax
+	  default: EmitByte(0x09); break;	// or %ecx, %eax
+	}
+	EmitByte(0xc8);
+	if (instr->opCode == OP_NOR) {
+	    EmitByte(0xf7);			// not %eax
+	    EmitByte(0xd0);
+	}
+	EmitStore(rd, EAX);
+	break;
+
+      case OP_ADDIU: case OP_ANDI: case OP_ORI: case OP_XORI:
+	if (rt == 0)
+	    return;
+	EmitLoad(EAX, rs);
+	switch (instr->opCode) {
+	  case OP_ADDIU:
+	    EmitByte(0x05);			// add $extra, %eax
+	    EmitWord(instr->extra);
+	    break;
+	  case OP_ANDI:
+	    EmitByte(0x25);			// and $imm, %eax
+	    EmitWord(instr->extra & 0xffff);
+	    break;
+	  case OP_ORI:
+	    EmitByte(0x0d);			// or $imm, %eax
+	    EmitWord(instr->extra & 0xffff);
+	    break;
+	  default:
+	    EmitByte(0x35);			// xor $imm, %eax
+	    EmitWord(instr->extra & 0xffff);
+	    break;
+	}
+	EmitStore(rt, EAX);
+	break;
+
+      case OP_LUI:
+	if (rt == 0)
+	    return;
+	EmitByte(0xc7);				// movl $imm, 4*rt(%ebx)
+	EmitByte(0x43);
+	EmitByte(rt * 4);
+	EmitWord(instr->extra << 16);
+	break;
+
+      // Note that OneInstruction shifts SRL and SRLV through a signed
+      // int, so they are arithmetic shifts here as well.
+      case OP_SLL: case OP_SRA: case OP_SRL:
+	if (rd == 0)
+	    return;
+	EmitLoad(EAX, rt);
+	EmitByte(0xc1);
+	EmitByte(instr->opCode == OP_SLL ? 0xe0 : 0xf8); // shl/sar $n, %eax
+	EmitByte(instr->extra);
+	EmitStore(rd, EAX);
+	break;
+
+      case OP_SLLV: case OP_SRAV: case OP_SRLV:
+	if (rd == 0)
+	    return;
+	EmitLoad(EAX, rt);
+	EmitLoad(ECX, rs);			// the count is masked to 5
+	EmitByte(0xd3);				// bits, as in OneInstruction
+	EmitByte(instr->opCode == OP_SLLV ? 0xe0 : 0xf8); // shl/sar %cl, %eax
+	EmitStore(rd, EAX);
+	break;
+
+      case OP_SLT: case OP_SLTU: case OP_SLTI: case OP_SLTIU:
+	if (instr->opCode == OP_SLT || instr->opCode == OP_SLTU) {
+	    if (rd == 0)
+		return;
+	    EmitLoad(EAX, rs);
+	    EmitLoad(ECX, rt);
+	    EmitByte(0x39);			// cmp %ecx, %eax
+	    EmitByte(0xc8);
+	} else {
+	    if (rt == 0)
+		return;
+	    rd = rt;
+	    EmitLoad(EAX, rs);
+	    EmitByte(0x3d);			// cmp $extra, %eax
+	    EmitWord(instr->extra);
+	}
+	EmitByte(0x0f);				// setl/setb %al
+	if (instr->opCode == OP_SLT || instr->opCode == OP_SLTI)
+	    EmitByte(0x9c);
+	else
+	    EmitByte(0x92);
+	EmitByte(0xc0);
+	EmitByte(0x0f);				// movzbl %al, %eax
+	EmitByte(0xb6);
+	EmitByte(0xc0);
+	EmitStore(rd, EAX);
+	break;
+
+      default:
+	ASSERTNOTREACHED();
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::RunJitBlock
+// 	Called by RunThreaded, when the instruction at PCReg is not in a
+//	delay slot and no delayed load is pending.  If a compiled run
+//	starts at the PC (compiling it first, if it has just become hot)
+//	and fits within "budget" instructions, run it and leave the
+//	machine exactly as that many calls to OneInstruction would.
+//
+//	With the DiffEngine, the run is first interpreted with
+//	OneInstruction, and the registers it produces are compared with
+//	the compiled code's; any difference is reported and we abort.
+//
+//	Returns the number of instructions run; 0 if the caller should
+//	interpret the instruction at the PC instead.  The caller charges
+//	the simulated time.
+//
+//	"slot" -- index of the PC's physical word
+//	"budget" -- # of instructions that can run before an interrupt
+//----------------------------------------------------------------------
+
+int
+Machine::RunJitBlock(int slot, int budget)
+{
+    int n = jit->Length(slot);
+    int pc = registers[PCReg];
+
+    if (n == 0) {
+	if (!jit->IsHot(slot))
+	    return 0;
+	int end = (slot / (PageSize / 4) + 1) * (PageSize / 4);
+	while (slot + n < end && n < 127 && Jit::CanCompile(Predecode(slot + n)))
+	    n++;
+	jit->Compile(slot, &decodeCache[slot], n);
+	n = jit->Length(slot);
+    }
+    if ((n <= 0) || (n > budget))
+	return 0;
+
+    int expected[NumTotalRegs];
+    if (engine == DiffEngine) {
+	int saved[NumTotalRegs];
+	Instruction *instr = new Instruction;
+
+	bcopy(registers, saved, sizeof(registers));
+	for (int i = 0; i < n; i++)
+	    OneInstruction(instr);
+	delete instr;
+	bcopy(registers, expected, sizeof(registers));
+	bcopy(saved, registers, sizeof(registers));
+    }
+
+    jit->Execute(slot);
+    registers[0] = 0;
+    registers[LoadValueReg] = 0;		// as DelayedLoad(0, 0) leaves it
+    registers[PrevPCReg] = pc + 4 * (n - 1);
+    registers[PCReg] = pc + 4 * n;
+    registers[NextPCReg] = pc + 4 * (n + 1);
+
+    if (engine == DiffEngine) {
+	bool same = TRUE;
+	for (int i = 0; i < NumTotalRegs; i++) {
+	    if (registers[i] != expected[i]) {
+		cout << "JIT mismatch in run at PC " << pc << " (" << n
+		     << " instructions): register " << i << " is "
+		     << registers[i] << ", interpreter has " << expected[i]
+		     << "\n";
+		same = FALSE;
+	    }
+	}
+	ASSERT(same);
+    }
+    return n;
+}
@@ -0,0 +1,80 @@
+// jit.h
+//	Data structures for translating user instructions into host code.
+//
+//	The threaded engine (Machine::RunThreaded) can hand hot runs of
+//	instructions to a Jit, which compiles them into x86 code kept in
+//	an executable code cache.  Only straight-line runs of register to
+//	register ALU instructions are compiled: anything that touches
+//	memory, branches, or can raise an exception is left to the
+//	interpreter, so that memory references still go through
+//	Machine::Translate and exceptions stay precise.
+//
+//	The generated code addresses the simulated registers through a
+//	base register, and uses only instruction encodings that mean the
+//	same thing in 32-bit and 64-bit mode; the same translator thus
+//	works for the -m32 build and for an x86-64 host.  On other hosts
+//	nothing is ever compiled.
+
+#ifndef JIT_H
+#define JIT_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Instruction;
+
+const int JitThreshold = 16;		// visits to a run before it is compiled
+const int JitCacheSize = 256 * 1024;	// bytes of host code, before we flush
+
+// The following class defines the code cache.  Compiled runs are
+// indexed the same way as the Machine's predecoded instructions: by
+// the physical word address of their first instruction.
+
+class Jit {
+  public:
+    Jit(int *regs, int slots);		// "regs" is the simulated register
+					// file; "slots" the # of words of
+					// physical memory
+    ~Jit();
+
+    static bool CanCompile(Instruction *instr);
+					// Can "instr" be part of a run?
+
+    int Length(int slot) { return length[slot]; }
+					// # of instructions in the run
+					// compiled at "slot"; 0 if none yet,
+					// -1 if there is nothing worth it
+    bool IsHot(int slot);		// Count one more visit to "slot";
+					// TRUE once it should be compiled
+    void Compile(int slot, Instruction *instrs, int count);
+					// Compile the "count" instructions
+					// starting at "instrs", for "slot"
+    void Execute(int slot) { (*entry[slot])(); }
+					// Run the code compiled at "slot"
+
+    void Invalidate(int firstSlot, int count);
+					// Forget the runs that start in
+					// these slots
+
+  private:
+    typedef void (*HostCode)();
+
+    int *registers;			// the simulated registers
+    int numSlots;
+    HostCode *entry;			// compiled code for each slot
+    char *length;			// see Length()
+    unsigned char *heat;		// visits, up to JitThreshold
+
+    char *cache;			// the executable code cache
+    int cacheUsed;			// bytes of it already handed out
+    char *emit;				// where the next byte of code goes
+
+    void Flush();			// empty the code cache
+    void EmitByte(int byte);
+    void EmitWord(int word);
+    void EmitLoad(int hostReg, int mipsReg);
+    void EmitStore(int mipsReg, int hostReg);
+    void EmitInstruction(Instruction *instr);
+};
+
+#endif // JIT_H
@@ -9,6 +9,8 @@
 
 #include "copyright.h"
 #include "machine.h"
+#include "jit.h"
+#include "cache.h"
 #include "main.h"
 
 // Textual names of the exceptions that can be generated by user program
@@ -50,9 +52,10 @@ void CheckEndian()
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"eng" -- the engine used to execute user instructions
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, SimEngine eng)
 {
     int i;
 
@@ -61,17 +64,37 @@ Machine::Machine(bool debug)
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
       	mainMemory[i] = 0;
-#ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-	tlb[i].valid = FALSE;
-    pageTable = NULL;
-#else	// use linear page table
+    decodeCache = new Instruction[MemorySize / 4];
+    decodeValid = new bool[MemorySize / 4];
+    threadedCode = new void *[MemorySize / 4];
+    for (i = 0; i < MemorySize / 4; i++) {
+	decodeValid[i] = FALSE;
+	threadedCode[i] = NULL;
+    }
+    for (i = 0; i < NumPhysPages; i++)
+	decodedPage[i] = FALSE;
     tlb = NULL;
+    tlbSize = tlbWays = 0;
+    tlbStamp = tlbHand = NULL;
+    tlbReferenced = NULL;
+    tlbReferences = 0;
     pageTable = NULL;
+#ifdef USE_TLB
+    EnableTLB(TLBSize, TLBSize, TLBFIFO);
 #endif
 
+    FlushSoftTLB();
+    icache = dcache = NULL;
+    profile = NULL;
+
     singleStep = debug;
+    engine = eng;
+    uncharged = 0;
+    trapCount = 0;
+    if (engine == JitEngine || engine == DiffEngine)
+	jit = new Jit(registers, MemorySize / 4);
+    else
+	jit = NULL;
     CheckEndian();
 }
 
@@ -83,8 +106,149 @@ Machine::Machine(bool debug)
 Machine::~Machine()
 {
     delete [] mainMemory;
-    if (tlb != NULL)
+    delete [] decodeCache;
+    delete [] decodeValid;
+    delete [] threadedCode;
+    if (jit != NULL)
+	delete jit;
+    if (icache != NULL)
+	delete icache;
+    if (dcache != NULL)
+	delete dcache;
+    if (tlb != NULL) {
         delete [] tlb;
+	delete [] tlbStamp;
+	delete [] tlbReferenced;
+	delete [] tlbHand;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::CacheReference
+// 	Simulate a reference to "physAddr" in the instruction or data
+//	cache.  A miss stalls the user program: the stall is charged as
+//	user time, on top of the instruction's own UserTick.
+//
+//	"cache" -- icache or dcache
+//	"physAddr" -- the physical address referenced
+//	"writing" -- TRUE for a store
+//----------------------------------------------------------------------
+
+void
+Machine::CacheReference(Cache *cache, int physAddr, bool writing)
+{
+    Statistics *stats = kernel->stats;
+    bool hit;
+    int stall = cache->Access(physAddr, writing, &hit);
+
+    if (cache == icache) {
+	if (hit)
+	    stats->numICacheHits++;
+	else
+	    stats->numICacheMisses++;
+    } else {
+	if (hit)
+	    stats->numDCacheHits++;
+	else
+	    stats->numDCacheMisses++;
+    }
+    stats->cacheStallTicks += stall;
+    stats->totalTicks += stall;
+    stats->userTicks += stall;
+}
+
+//----------------------------------------------------------------------
+// Machine::EnableTLB
+// 	Switch address translation over to a software-loaded TLB.  From
+//	now on Translate only looks in the TLB, and raises a
+//	PageFaultException for any page that is not there; it is up to the
+//	kernel to refill the TLB (using TLBReplace to pick the entry), and
+//	to copy the use and dirty bits back into its page tables.
+//
+//	"size" -- the number of TLB entries
+//	"ways" -- the associativity: the number of entries in each set;
+//		"size" for a fully associative TLB
+//	"policy" -- how TLBReplace chooses among the entries of a set
+//----------------------------------------------------------------------
+
+void
+Machine::EnableTLB(int size, int ways, TLBPolicy policy)
+{
+    ASSERT(tlb == NULL);
+    ASSERT(size > 0 && ways > 0 && size % ways == 0);
+
+    tlbSize = size;
+    tlbWays = ways;
+    tlbPolicy = policy;
+    tlb = new TranslationEntry[size];
+    tlbStamp = new int[size];
+    tlbReferenced = new bool[size];
+    for (int i = 0; i < size; i++) {
+	tlb[i].valid = FALSE;
+	tlbStamp[i] = 0;
+	tlbReferenced[i] = FALSE;
+    }
+    tlbHand = new int[size / ways];
+    for (int i = 0; i < size / ways; i++)
+	tlbHand[i] = 0;
+    pageTable = NULL;
+    FlushSoftTLB();
+}
+
+//----------------------------------------------------------------------
+// Machine::TLBReplace
+// 	Choose the TLB entry that the kernel should load with the
+//	translation for virtual page "vpn", on a TLB miss.  The entry is
+//	taken from the set that "vpn" maps to: an invalid one if there is
+//	any, otherwise the one picked by the replacement policy.  The
+//	caller must save the use and dirty bits of the entry, if it is
+//	valid, before overwriting it.
+//
+//	Returns the index of the entry in "tlb".
+//----------------------------------------------------------------------
+
+int
+Machine::TLBReplace(int vpn)
+{
+    int first = (vpn % (tlbSize / tlbWays)) * tlbWays;
+    int victim = first;
+    int i;
+
+    for (i = first; i < first + tlbWays; i++)
+	if (!tlb[i].valid) {
+	    victim = i;
+	    goto found;
+	}
+
+    switch (tlbPolicy) {
+      case TLBRandom:
+	victim = first + RandomNumber() % tlbWays;
+	break;
+
+      case TLBFIFO:			// both keep the oldest stamp
+      case TLBLRU:
+	for (i = first; i < first + tlbWays; i++)
+	    if (tlbStamp[i] < tlbStamp[victim])
+		victim = i;
+	break;
+
+      case TLBClock:
+	for (;;) {
+	    i = first + tlbHand[first / tlbWays];
+	    tlbHand[first / tlbWays] = (tlbHand[first / tlbWays] + 1) % tlbWays;
+	    if (!tlbReferenced[i]) {
+		victim = i;
+		break;
+	    }
+	    tlbReferenced[i] = FALSE;	// give it a second chance
+	}
+	break;
+    }
+
+  found:
+    tlbStamp[victim] = tlbReferences;	// filled (and used) now
+    tlbReferenced[victim] = TRUE;
+    return victim;
 }
 
 //----------------------------------------------------------------------
@@ -101,6 +265,12 @@ void
 Machine::RaiseException(ExceptionType which, int badVAddr)
 {
     DEBUG(dbgMach, "Exception: " << exceptionNames[which]);
+    if (uncharged > 0) {		// batch engine: the kernel must see
+	kernel->stats->totalTicks += uncharged * UserTick; // the time of
+	kernel->stats->userTicks += uncharged * UserTick;  // the trap
+	uncharged = 0;
+    }
+    trapCount++;
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// finish anything in progress
     kernel->interrupt->setStatus(SystemMode);
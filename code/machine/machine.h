@@ -24,6 +24,7 @@
 #include "copyright.h"
 #include "utility.h"
 #include "translate.h"
+#include "pagetable.h"
 
 // Definitions related to the size, and format of user memory
 
@@ -40,6 +41,16 @@ const int NumPhysPages = 128;
 const int MemorySize = (NumPhysPages * PageSize);
 const int TLBSize = 4;			// if there is a TLB, make it small
 
+// How the kernel picks which TLB entry to replace on a TLB miss.  Only
+// the entries of the set that the page maps to are candidates; an
+// invalid entry is always used first.
+
+enum TLBPolicy { TLBRandom,		// any entry of the set
+		 TLBFIFO,		// the one filled longest ago
+		 TLBLRU,		// the one used longest ago
+		 TLBClock		// second chance, by reference bits
+};
+
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
 		     PageFaultException,    // No valid translation found
@@ -92,12 +103,68 @@ enum ExceptionType { NoException,           // Everything ok!
 // The procedures in this class are defined in machine.cc, mipssim.cc, and
 // translate.cc.
 
-class Instruction;
+// The following class defines an instruction, represented in both
+// 	undecoded binary form
+//      decoded to identify
+//	    operation to do
+//	    registers to act on
+//	    any immediate operand value
+
+class Instruction {
+  public:
+    void Decode();	// decode the binary representation of the instruction
+
+    unsigned int value; // binary representation of the instruction
+
+    char opCode;     // Type of instruction.  This is NOT the same as the
+    		     // opcode field from the instruction: see defs in mips.h
+    char rs, rt, rd; // Three registers from instruction.
+    int extra;       // Immediate or target or shamt field or offset.
+                     // Immediates are sign-extended.
+};
+
+// A host-side cache of recent translations (the "soft TLB"), consulted
+// before Translate by ReadMem, WriteMem and instruction fetch.  It is
+// direct-mapped by virtual page number, and maps straight to the page's
+// bytes in mainMemory.  An entry allows reads only once the page's use
+// bit is set, and writes only once its dirty bit is set too, so a hit
+// never has to touch the translation entry itself.
+
+const int SoftTLBSize = 64;		// # of entries; must be a power of 2
+
+#define SoftRead	0x1		// permission bits of a soft TLB entry
+#define SoftWrite	0x2
+
+class SoftTLBEntry {
+  public:
+    int vpn;			// virtual page #, or -1 if the entry is empty
+    char *page;			// the page's bytes in mainMemory
+    int perm;			// SoftRead and/or SoftWrite
+};
+
 class Interrupt;
+class Jit;
+class Cache;
+class Profile;
+
+// The engines that can execute user instructions.  The reference engine
+// (OneInstruction) decodes, executes and ticks one instruction at a time;
+// the threaded engine (RunThreaded) jumps from handler to handler through
+// a whole block of straight-line code before going back to the interrupt
+// check.  The JIT engine is the threaded engine, plus host code compiled
+// for hot runs of ALU instructions (see jit.h); the diff engine is the
+// JIT engine checking every compiled run against OneInstruction.  The
+// batch engine is the reference engine, charging simulated time in bulk
+// up to the next pending interrupt (RunBatched).  All of them give
+// exactly the same simulated results.
+
+enum SimEngine { ReferenceEngine, ThreadedEngine, JitEngine, DiffEngine,
+		 BatchEngine };
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
+    Machine(bool debug, SimEngine eng = ReferenceEngine);
+				// Initialize the simulation of the hardware
 				// for running user programs
     ~Machine();			// De-allocate the data structures
 
@@ -121,11 +188,11 @@ class Machine {
 // NOTE: the hardware translation of virtual addresses in the user program
 // to physical addresses (relative to the beginning of "mainMemory")
 // can be controlled by one of:
-//	a traditional linear page table
+//	a page table: linear, two-level or hashed (see pagetable.h)
 //  	a software-loaded translation lookaside buffer (tlb) -- a cache of 
 //	  mappings of virtual page #'s to physical page #'s
 //
-// If "tlb" is NULL, the linear page table is used
+// If "tlb" is NULL, the page table is used
 // If "tlb" is non-NULL, the Nachos kernel is responsible for managing
 //	the contents of the TLB.  But the kernel can use any data structure
 //	it wants (eg, segmented paging) for handling TLB cache misses.
@@ -138,15 +205,44 @@ class Machine {
 
     TranslationEntry *tlb;		// this pointer should be considered 
 					// "read-only" to Nachos kernel code
+    int tlbSize;			// # of entries in the TLB, if any
+    int tlbWays;			// # of entries in each set; the set of
+					// virtual page "vpn" is vpn % (size/ways)
+
+    void EnableTLB(int size, int ways, TLBPolicy policy);
+				// Translate through a TLB of "size" entries
+				// from now on, instead of a page table
+    int TLBReplace(int vpn);	// Pick the TLB entry the kernel should fill
+				// with the translation for "vpn"
 
-    TranslationEntry *pageTable;
+    PageTable *pageTable;
     unsigned int pageTableSize;
 
+    Cache *icache;		// if not NULL, simulate the timing of an
+    Cache *dcache;		// instruction and/or a data cache; the
+				// Machine deletes them
+
+    Profile *profile;		// if not NULL, count each instruction
+				// into it; the kernel sets it along with
+				// the page table
+
     bool ReadMem(int addr, int size, int* value);
     bool WriteMem(int addr, int size, int value);
     				// Read or write 1, 2, or 4 bytes of virtual 
 				// memory (at addr).  Return FALSE if a 
 				// correct translation couldn't be found.
+
+    void FlushSoftTLB();	// Empty the soft TLB.  The kernel must call
+				// this whenever it switches page tables,
+				// changes a translation in the page table
+				// or the TLB, or clears a use or dirty bit.
+
+    void InvalidateDecodedPage(int pageFrame);
+				// Forget any predecoded instructions held
+				// for physical page "pageFrame".  The kernel
+				// must call this whenever it changes the
+				// contents of a frame behind the simulator's
+				// back, or hands the frame to a new owner.
   private:
 
 // Routines internal to the machine simulation -- DO NOT call these directly
@@ -155,9 +251,36 @@ class Machine {
 
     void OneInstruction(Instruction *instr); 	
     				// Run one instruction of a user program.
+
+    void RunBatched();		// Run a user program with the batch
+				// engine; never returns
+
+    void RunThreaded();		// Run a user program with the threaded
+				// engine; never returns
+
+    int RunJitBlock(int slot, int budget);
+				// Run the compiled code for the instructions
+				// at PCReg, if any; return how many ran
+
+    Instruction *Predecode(int slot);
+				// Return the predecoded instruction for word
+				// "slot" of mainMemory, decoding it if need be
+
+    bool FetchInstruction(Instruction *instr);
+				// Fetch and decode the instruction at PCReg,
+				// from the predecode cache when possible.
+				// Return FALSE if the fetch trapped.
     
 
 
+    void CacheReference(Cache *cache, int physAddr, bool writing);
+				// Charge a reference to "physAddr" in
+				// "cache", and count the hit or miss
+
+    char *SoftTranslate(int virtAddr, int size, int perm);
+				// Look "virtAddr" up in the soft TLB; return
+				// its host address, or NULL on a miss
+
     ExceptionType Translate(int virtAddr, int* physAddr, int size,bool writing);
     				// Translate an address, and check for 
 				// alignment.  Set the use and dirty bits in 
@@ -177,10 +300,35 @@ class Machine {
 
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
 
+    SoftTLBEntry softTLB[SoftTLBSize]; // recent translations, see above
+
+    TLBPolicy tlbPolicy;	// how TLBReplace picks an entry
+    int *tlbStamp;		// per entry: when it was filled (FIFO) or
+				// last used (LRU), in TLB references
+    bool *tlbReferenced;	// per entry: clock reference bit
+    int *tlbHand;		// per set: where the clock hand points
+    int tlbReferences;		// # of TLB lookups so far
+
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
 				// time reaches this value
+    SimEngine engine;		// which engine Run() uses
+    int uncharged;		// batch engine: # of instructions run, but
+				// not yet charged to simulated time
+    int trapCount;		// # of calls to RaiseException so far
+
+// Predecoded instruction cache: one slot per word of mainMemory.  The
+// slots of a physical page are only consulted while decodedPage[] is set
+// for it; any write into the page drops all of them at once.
+
+    Instruction *decodeCache;	// decoded copy of each word of mainMemory
+    bool *decodeValid;		// is decodeCache[i] up to date?
+    bool decodedPage[NumPhysPages]; // does the frame have any valid slots?
+    void **threadedCode;	// for RunThreaded: address of the handler
+				// for decodeCache[i], or NULL if not yet
+				// looked up; cleared along with decodeValid
+    Jit *jit;			// compiled runs, for the JIT and diff engines
 
     friend class Interrupt;		// calls DelayedLoad()    
 };
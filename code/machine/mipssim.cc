@@ -20,30 +20,122 @@
 #include "debug.h"
 #include "machine.h"
 #include "mipssim.h"
+#include "jit.h"
+#include "profile.h"
 #include "main.h"
 
-static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
-
-// The following class defines an instruction, represented in both
-// 	undecoded binary form
-//      decoded to identify
-//	    operation to do
-//	    registers to act on
-//	    any immediate operand value
+/*
+ * The table below is used to translate bits 31:26 of the instruction
+ * into a value suitable for the "opCode" field of a MemWord structure,
+ * or into a special value for further decoding.
+ */
 
-class Instruction {
-  public:
-    void Decode();	// decode the binary representation of the instruction
+static OpInfo opTable[] = {
+    {SPECIAL, RFMT}, {BCOND, IFMT}, {OP_J, JFMT}, {OP_JAL, JFMT},
+    {OP_BEQ, IFMT}, {OP_BNE, IFMT}, {OP_BLEZ, IFMT}, {OP_BGTZ, IFMT},
+    {OP_ADDI, IFMT}, {OP_ADDIU, IFMT}, {OP_SLTI, IFMT}, {OP_SLTIU, IFMT},
+    {OP_ANDI, IFMT}, {OP_ORI, IFMT}, {OP_XORI, IFMT}, {OP_LUI, IFMT},
+    {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
+    {OP_LB, IFMT}, {OP_LH, IFMT}, {OP_LWL, IFMT}, {OP_LW, IFMT},
+    {OP_LBU, IFMT}, {OP_LHU, IFMT}, {OP_LWR, IFMT}, {OP_RES, IFMT},
+    {OP_SB, IFMT}, {OP_SH, IFMT}, {OP_SWL, IFMT}, {OP_SW, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_SWR, IFMT}, {OP_RES, IFMT},
+    {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
+    {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}
+};
 
-    unsigned int value; // binary representation of the instruction
+/*
+ * The table below is used to convert the "funct" field of SPECIAL
+ * instructions into the "opCode" field of a MemWord.
+ */
 
-    char opCode;     // Type of instruction.  This is NOT the same as the
-    		     // opcode field from the instruction: see defs in mips.h
-    char rs, rt, rd; // Three registers from instruction.
-    int extra;       // Immediate or target or shamt field or offset.
-                     // Immediates are sign-extended.
+static int specialTable[] = {
+    OP_SLL, OP_RES, OP_SRL, OP_SRA, OP_SLLV, OP_RES, OP_SRLV, OP_SRAV,
+    OP_JR, OP_JALR, OP_RES, OP_RES, OP_SYSCALL, OP_UNIMP, OP_RES, OP_RES,
+    OP_MFHI, OP_MTHI, OP_MFLO, OP_MTLO, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_MULT, OP_MULTU, OP_DIV, OP_DIVU, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_ADD, OP_ADDU, OP_SUB, OP_SUBU, OP_AND, OP_OR, OP_XOR, OP_NOR,
+    OP_RES, OP_RES, OP_SLT, OP_SLTU, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES
 };
 
+// Printed versions of each instruction, for debugging
+
+static struct OpString opStrings[] = {
+	{"Shouldn't happen", {NONE, NONE, NONE}},
+	{"ADD r%d,r%d,r%d", {RD, RS, RT}},
+	{"ADDI r%d,r%d,%d", {RT, RS, EXTRA}},
+	{"ADDIU r%d,r%d,%d", {RT, RS, EXTRA}},
+	{"ADDU r%d,r%d,r%d", {RD, RS, RT}},
+	{"AND r%d,r%d,r%d", {RD, RS, RT}},
+	{"ANDI r%d,r%d,%d", {RT, RS, EXTRA}},
+	{"BEQ r%d,r%d,%d", {RS, RT, EXTRA}},
+	{"BGEZ r%d,%d", {RS, EXTRA, NONE}},
+	{"BGEZAL r%d,%d", {RS, EXTRA, NONE}},
+	{"BGTZ r%d,%d", {RS, EXTRA, NONE}},
+	{"BLEZ r%d,%d", {RS, EXTRA, NONE}},
+	{"BLTZ r%d,%d", {RS, EXTRA, NONE}},
+	{"BLTZAL r%d,%d", {RS, EXTRA, NONE}},
+	{"BNE r%d,r%d,%d", {RS, RT, EXTRA}},
+	{"Shouldn't happen", {NONE, NONE, NONE}},
+	{"DIV r%d,r%d", {RS, RT, NONE}},
+	{"DIVU r%d,r%d", {RS, RT, NONE}},
+	{"J %d", {EXTRA, NONE, NONE}},
+	{"JAL %d", {EXTRA, NONE, NONE}},
+	{"JALR r%d,r%d", {RD, RS, NONE}},
+	{"JR r%d,r%d", {RD, RS, NONE}},
+	{"LB r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"LBU r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"LH r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"LHU r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"LUI r%d,%d", {RT, EXTRA, NONE}},
+	{"LW r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"LWL r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"LWR r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"Shouldn't happen", {NONE, NONE, NONE}},
+	{"MFHI r%d", {RD, NONE, NONE}},
+	{"MFLO r%d", {RD, NONE, NONE}},
+	{"Shouldn't happen", {NONE, NONE, NONE}},
+	{"MTHI r%d", {RS, NONE, NONE}},
+	{"MTLO r%d", {RS, NONE, NONE}},
+	{"MULT r%d,r%d", {RS, RT, NONE}},
+	{"MULTU r%d,r%d", {RS, RT, NONE}},
+	{"NOR r%d,r%d,r%d", {RD, RS, RT}},
+	{"OR r%d,r%d,r%d", {RD, RS, RT}},
+	{"ORI r%d,r%d,%d", {RT, RS, EXTRA}},
+	{"RFE", {NONE, NONE, NONE}},
+	{"SB r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"SH r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"SLL r%d,r%d,%d", {RD, RT, EXTRA}},
+	{"SLLV r%d,r%d,r%d", {RD, RT, RS}},
+	{"SLT r%d,r%d,r%d", {RD, RS, RT}},
+	{"SLTI r%d,r%d,%d", {RT, RS, EXTRA}},
+	{"SLTIU r%d,r%d,%d", {RT, RS, EXTRA}},
+	{"SLTU r%d,r%d,r%d", {RD, RS, RT}},
+	{"SRA r%d,r%d,%d", {RD, RT, EXTRA}},
+	{"SRAV r%d,r%d,r%d", {RD, RT, RS}},
+	{"SRL r%d,r%d,%d", {RD, RT, EXTRA}},
+	{"SRLV r%d,r%d,r%d", {RD, RT, RS}},
+	{"SUB r%d,r%d,r%d", {RD, RS, RT}},
+	{"SUBU r%d,r%d,r%d", {RD, RS, RT}},
+	{"SW r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"SWL r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"SWR r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"XOR r%d,r%d,r%d", {RD, RS, RT}},
+	{"XORI r%d,r%d,%d", {RT, RS, EXTRA}},
+	{"SYSCALL", {NONE, NONE, NONE}},
+	{"Unimplemented", {NONE, NONE, NONE}},
+	{"Reserved", {NONE, NONE, NONE}}
+      };
+
+static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
+
 //----------------------------------------------------------------------
 // Machine::Run
 // 	Simulate the execution of a user-level program on Nachos.
@@ -56,6 +148,27 @@ void
 Machine::Run()
 {
     Instruction *instr = new Instruction;  // storage for decoded instruction
+
+    // The threaded engine skips the per-instruction hooks, and fetches
+    // without translating every instruction, so anything that wants to
+    // watch each instruction, or a simulated TLB, gets the reference
+    // engine.  So do the caches, whose stalls neither of the other
+    // engines can fit into its time budget, and the profiler.
+    if (engine == BatchEngine && !singleStep
+	  && icache == NULL && dcache == NULL && profile == NULL
+	  && !debug->IsEnabled(dbgInt) && !debug->IsEnabled(dbgTraCode)) {
+	delete instr;
+	RunBatched();		// never returns
+    }
+    if (engine != ReferenceEngine && engine != BatchEngine && !singleStep
+	  && tlb == NULL && icache == NULL && dcache == NULL && profile == NULL
+	  && !debug->IsEnabled(dbgMach)
+	  && !debug->IsEnabled(dbgInt) && !debug->IsEnabled(dbgAddr)
+	  && !debug->IsEnabled(dbgTraCode)) {
+	delete instr;
+	RunThreaded();		// never returns
+    }
+
     if (debug->IsEnabled('m')) {
         cout << "Starting program in thread: " << kernel->currentThread->getName();
 	cout << ", at time: " << kernel->stats->totalTicks << "\n";
@@ -71,10 +184,496 @@ Machine::Run()
 	DEBUG(dbgTraCode, "In Machine::Run(), return from OneTick " << "== Tick " << kernel->stats->totalTicks << " ==");
 	if (singleStep && (runUntilTime <= kernel->stats->totalTicks))
 		Debugger();
+	if (kernel->numCpus > 1)
+	    kernel->scheduler->SwitchCpu();	// let the others catch up
     }
 }
 
 
+//----------------------------------------------------------------------
+// Machine::RunBatched
+// 	Simulate the execution of a user-level program, like Run, but
+//	without calling Interrupt::OneTick after every instruction.
+//
+//	Until the next pending interrupt is due, OneTick would do nothing
+//	but advance the clock.  So we ask the interrupt system when that
+//	is, run every instruction before that point back to back, and
+//	then charge their UserTicks all at once.  The instruction whose
+//	tick makes the interrupt due goes through OneTick as usual, so
+//	CheckIfDue runs at exactly the same simulated time as in Run.
+//
+//	If an instruction traps, RaiseException charges the batch so far
+//	before the kernel gets control, and we finish the trapping
+//	instruction with OneTick, just as Run does.  Since the kernel may
+//	have run other threads meanwhile, we notice the trap by the
+//	change in trapCount rather than by any flag of our own.
+//----------------------------------------------------------------------
+
+void
+Machine::RunBatched()
+{
+    Instruction *instr = new Instruction;  // storage for decoded instruction
+    Statistics *stats = kernel->stats;
+    Interrupt *interrupt = kernel->interrupt;
+    int when, budget, traps;
+
+    if (debug->IsEnabled('m')) {
+        cout << "Starting program in thread: " << kernel->currentThread->getName();
+	cout << ", at time: " << kernel->stats->totalTicks << "\n";
+    }
+    interrupt->setStatus(UserMode);
+    for (;;) {
+	when = interrupt->NextInterruptTime();
+	if (when < 0)
+	    budget = 1 << 30;		// nothing pending, no limit
+	else
+	    budget = (when - stats->totalTicks - 1) / UserTick;
+
+	traps = trapCount;
+	uncharged = 0;
+	while (uncharged < budget) {
+	    OneInstruction(instr);
+	    if (trapCount != traps)
+		break;			// already charged by RaiseException
+	    uncharged++;
+	}
+	stats->totalTicks += uncharged * UserTick;
+	stats->userTicks += uncharged * UserTick;
+	uncharged = 0;
+
+	if (trapCount == traps)		// an interrupt is due after
+	    OneInstruction(instr);	// this instruction
+	interrupt->OneTick();
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::RunThreaded
+// 	Simulate the execution of a user-level program, like Run, but
+//	with direct-threaded dispatch: next to its predecoded form, each
+//	word of memory records the address of the handler that executes
+//	it, and each handler jumps straight on to the handler of the
+//	next instruction, rather than returning to a switch and to
+//	Interrupt::OneTick.
+//
+//	A block starts wherever the PC is, and goes on for as long as
+//	control stays within the same virtual page and no interrupt can
+//	become due.  The PC is translated only at the start of a block;
+//	this is exact, because the page table can only change by trapping
+//	to the kernel, and a trap always ends the block.
+//
+//	Every instruction is still charged one UserTick, in the same
+//	order as in Run, and the instruction whose tick would make an
+//	interrupt due is run by OneInstruction and OneTick.  Delayed loads
+//	and branch delay slots are kept in the registers exactly as
+//	OneInstruction keeps them.  The rare instructions (unaligned
+//	loads and stores, syscalls, unimplemented opcodes) are simply
+//	left to OneInstruction as well.
+//
+//	With the JIT and diff engines, whenever the PC is neither in a
+//	delay slot nor waiting on a delayed load, RunJitBlock gets the
+//	first chance to run the instructions there as compiled code.
+//----------------------------------------------------------------------
+
+void
+Machine::RunThreaded()
+{
+    Instruction *instr = new Instruction;  // for OneInstruction
+    Statistics *stats = kernel->stats;
+    Interrupt *interrupt = kernel->interrupt;
+    void *handler[MaxOpcode + 1];	// handler address for each opcode
+    Instruction *ip;		// the instruction being executed
+    int blockPC;		// virtual address the block started at
+    int frameBase;		// physical address of the block's page
+    int slot;			// index of "ip" in decodeCache
+    int budget;			// # of instructions before an interrupt
+    int ran;			// # of instructions run by compiled code
+    int when, physicalAddress;
+    ExceptionType exception;
+    int nextLoadReg, nextLoadValue, pcAfter;
+    int sum, diff, tmp, value;
+    unsigned int rs, rt, imm;
+    int rsReg, rtReg, rdReg;	// the register fields of "ip"
+
+    for (int i = 0; i <= MaxOpcode; i++)
+	handler[i] = &&op_reference;
+    handler[OP_ADD] = &&op_ADD;		handler[OP_ADDI] = &&op_ADDI;
+    handler[OP_ADDIU] = &&op_ADDIU;	handler[OP_ADDU] = &&op_ADDU;
+    handler[OP_AND] = &&op_AND;		handler[OP_ANDI] = &&op_ANDI;
+    handler[OP_BEQ] = &&op_BEQ;		handler[OP_BGEZ] = &&op_BGEZ;
+    handler[OP_BGEZAL] = &&op_BGEZAL;	handler[OP_BGTZ] = &&op_BGTZ;
+    handler[OP_BLEZ] = &&op_BLEZ;	handler[OP_BLTZ] = &&op_BLTZ;
+    handler[OP_BLTZAL] = &&op_BLTZAL;	handler[OP_BNE] = &&op_BNE;
+    handler[OP_DIV] = &&op_DIV;		handler[OP_DIVU] = &&op_DIVU;
+    handler[OP_J] = &&op_J;		handler[OP_JAL] = &&op_JAL;
+    handler[OP_JALR] = &&op_JALR;	handler[OP_JR] = &&op_JR;
+    handler[OP_LB] = &&op_LB;		handler[OP_LBU] = &&op_LBU;
+    handler[OP_LH] = &&op_LH;		handler[OP_LHU] = &&op_LHU;
+    handler[OP_LUI] = &&op_LUI;		handler[OP_LW] = &&op_LW;
+    handler[OP_MFHI] = &&op_MFHI;	handler[OP_MFLO] = &&op_MFLO;
+    handler[OP_MTHI] = &&op_MTHI;	handler[OP_MTLO] = &&op_MTLO;
+    handler[OP_MULT] = &&op_MULT;	handler[OP_MULTU] = &&op_MULTU;
+    handler[OP_NOR] = &&op_NOR;		handler[OP_OR] = &&op_OR;
+    handler[OP_ORI] = &&op_ORI;		handler[OP_SB] = &&op_SB;
+    handler[OP_SH] = &&op_SH;		handler[OP_SLL] = &&op_SLL;
+    handler[OP_SLLV] = &&op_SLLV;	handler[OP_SLT] = &&op_SLT;
+    handler[OP_SLTI] = &&op_SLTI;	handler[OP_SLTIU] = &&op_SLTIU;
+    handler[OP_SLTU] = &&op_SLTU;	handler[OP_SRA] = &&op_SRA;
+    handler[OP_SRAV] = &&op_SRAV;	handler[OP_SRL] = &&op_SRL;
+    handler[OP_SRLV] = &&op_SRLV;	handler[OP_SUB] = &&op_SUB;
+    handler[OP_SUBU] = &&op_SUBU;	handler[OP_SW] = &&op_SW;
+    handler[OP_XOR] = &&op_XOR;		handler[OP_XORI] = &&op_XORI;
+
+    interrupt->setStatus(UserMode);
+    for (;;) {
+	// Start a new block at the PC.  It may run up to, but not
+	// including, the instruction whose tick makes an interrupt due.
+	when = interrupt->NextInterruptTime();
+	if (when < 0)
+	    budget = 1 << 30;		// nothing pending, no limit
+	else
+	    budget = (when - stats->totalTicks - 1) / UserTick;
+	if (budget <= 0)
+	    goto reference;
+
+	blockPC = registers[PCReg];
+	exception = Translate(blockPC, &physicalAddress, 4, FALSE);
+	if (exception != NoException) {
+	    RaiseException(exception, blockPC);
+	    interrupt->OneTick();
+	    continue;
+	}
+	frameBase = physicalAddress - (blockPC & (PageSize - 1));
+
+      dispatch:
+	slot = (frameBase + (registers[PCReg] & (PageSize - 1))) / 4;
+	if (jit != NULL && registers[LoadReg] == 0
+	      && registers[NextPCReg] == registers[PCReg] + 4
+	      && (ran = RunJitBlock(slot, budget)) > 0) {
+	    stats->totalTicks += ran * UserTick;
+	    stats->userTicks += ran * UserTick;
+	    budget -= ran;
+	    goto next;
+	}
+	if (threadedCode[slot] == NULL)
+	    threadedCode[slot] = handler[(int) Predecode(slot)->opCode];
+	ip = &decodeCache[slot];
+	rsReg = ip->rs;
+	rtReg = ip->rt;
+	rdReg = ip->rd;
+	nextLoadReg = 0;
+	nextLoadValue = 0;
+	pcAfter = registers[NextPCReg] + 4;
+	goto *threadedCode[slot];
+
+      op_ADD:
+	sum = registers[rsReg] + registers[rtReg];
+	if (!((registers[rsReg] ^ registers[rtReg]) & SIGN_BIT) &&
+	    ((registers[rsReg] ^ sum) & SIGN_BIT)) {
+	    RaiseException(OverflowException, 0);
+	    goto trapped;
+	}
+	registers[rdReg] = sum;
+	goto retire;
+
+      op_ADDI:
+	sum = registers[rsReg] + ip->extra;
+	if (!((registers[rsReg] ^ ip->extra) & SIGN_BIT) &&
+	    ((ip->extra ^ sum) & SIGN_BIT)) {
+	    RaiseException(OverflowException, 0);
+	    goto trapped;
+	}
+	registers[rtReg] = sum;
+	goto retire;
+
+      op_ADDIU:
+	registers[rtReg] = registers[rsReg] + ip->extra;
+	goto retire;
+
+      op_ADDU:
+	registers[rdReg] = registers[rsReg] + registers[rtReg];
+	goto retire;
+
+      op_AND:
+	registers[rdReg] = registers[rsReg] & registers[rtReg];
+	goto retire;
+
+      op_ANDI:
+	registers[rtReg] = registers[rsReg] & (ip->extra & 0xffff);
+	goto retire;
+
+      op_BEQ:
+	if (registers[rsReg] == registers[rtReg])
+	    pcAfter = registers[NextPCReg] + IndexToAddr(ip->extra);
+	goto retire;
+
+      op_BGEZAL:
+	registers[R31] = registers[NextPCReg] + 4;
+      op_BGEZ:
+	if (!(registers[rsReg] & SIGN_BIT))
+	    pcAfter = registers[NextPCReg] + IndexToAddr(ip->extra);
+	goto retire;
+
+      op_BGTZ:
+	if (registers[rsReg] > 0)
+	    pcAfter = registers[NextPCReg] + IndexToAddr(ip->extra);
+	goto retire;
+
+      op_BLEZ:
+	if (registers[rsReg] <= 0)
+	    pcAfter = registers[NextPCReg] + IndexToAddr(ip->extra);
+	goto retire;
+
+      op_BLTZAL:
+	registers[R31] = registers[NextPCReg] + 4;
+      op_BLTZ:
+	if (registers[rsReg] & SIGN_BIT)
+	    pcAfter = registers[NextPCReg] + IndexToAddr(ip->extra);
+	goto retire;
+
+      op_BNE:
+	if (registers[rsReg] != registers[rtReg])
+	    pcAfter = registers[NextPCReg] + IndexToAddr(ip->extra);
+	goto retire;
+
+      op_DIV:
+	if (registers[rtReg] == 0) {
+	    registers[LoReg] = 0;
+	    registers[HiReg] = 0;
+	} else {
+	    registers[LoReg] =  registers[rsReg] / registers[rtReg];
+	    registers[HiReg] = registers[rsReg] % registers[rtReg];
+	}
+	goto retire;
+
+      op_DIVU:
+	rs = (unsigned int) registers[rsReg];
+	rt = (unsigned int) registers[rtReg];
+	if (rt == 0) {
+	    registers[LoReg] = 0;
+	    registers[HiReg] = 0;
+	} else {
+	    tmp = rs / rt;
+	    registers[LoReg] = (int) tmp;
+	    tmp = rs % rt;
+	    registers[HiReg] = (int) tmp;
+	}
+	goto retire;
+
+      op_JAL:
+	registers[R31] = registers[NextPCReg] + 4;
+      op_J:
+	pcAfter = (pcAfter & 0xf0000000) | IndexToAddr(ip->extra);
+	goto retire;
+
+      op_JALR:
+	registers[rdReg] = registers[NextPCReg] + 4;
+      op_JR:
+	pcAfter = registers[rsReg];
+	goto retire;
+
+      op_LB:
+      op_LBU:
+	tmp = registers[rsReg] + ip->extra;
+	if (!ReadMem(tmp, 1, &value))
+	    goto trapped;
+	if ((value & 0x80) && (ip->opCode == OP_LB))
+	    value |= 0xffffff00;
+	else
+	    value &= 0xff;
+	nextLoadReg = rtReg;
+	nextLoadValue = value;
+	goto retire;
+
+      op_LH:
+      op_LHU:
+	tmp = registers[rsReg] + ip->extra;
+	if (tmp & 0x1) {
+	    RaiseException(AddressErrorException, tmp);
+	    goto trapped;
+	}
+	if (!ReadMem(tmp, 2, &value))
+	    goto trapped;
+	if ((value & 0x8000) && (ip->opCode == OP_LH))
+	    value |= 0xffff0000;
+	else
+	    value &= 0xffff;
+	nextLoadReg = rtReg;
+	nextLoadValue = value;
+	goto retire;
+
+      op_LUI:
+	registers[rtReg] = ip->extra << 16;
+	goto retire;
+
+      op_LW:
+	tmp = registers[rsReg] + ip->extra;
+	if (tmp & 0x3) {
+	    RaiseException(AddressErrorException, tmp);
+	    goto trapped;
+	}
+	if (!ReadMem(tmp, 4, &value))
+	    goto trapped;
+	nextLoadReg = rtReg;
+	nextLoadValue = value;
+	goto retire;
+
+      op_MFHI:
+	registers[rdReg] = registers[HiReg];
+	goto retire;
+
+      op_MFLO:
+	registers[rdReg] = registers[LoReg];
+	goto retire;
+
+      op_MTHI:
+	registers[HiReg] = registers[rsReg];
+	goto retire;
+
+      op_MTLO:
+	registers[LoReg] = registers[rsReg];
+	goto retire;
+
+      op_MULT:
+	Mult(registers[rsReg], registers[rtReg], TRUE,
+	     &registers[HiReg], &registers[LoReg]);
+	goto retire;
+
+      op_MULTU:
+	Mult(registers[rsReg], registers[rtReg], FALSE,
+	     &registers[HiReg], &registers[LoReg]);
+	goto retire;
+
+      op_NOR:
+	registers[rdReg] = ~(registers[rsReg] | registers[rtReg]);
+	goto retire;
+
+      op_OR:
+	registers[rdReg] = registers[rsReg] | registers[rtReg];
+	goto retire;
+
+      op_ORI:
+	registers[rtReg] = registers[rsReg] | (ip->extra & 0xffff);
+	goto retire;
+
+      op_SB:
+	if (!WriteMem((unsigned) 
+		(registers[rsReg] + ip->extra), 1, registers[rtReg]))
+	    goto trapped;
+	goto retire;
+
+      op_SH:
+	if (!WriteMem((unsigned) 
+		(registers[rsReg] + ip->extra), 2, registers[rtReg]))
+	    goto trapped;
+	goto retire;
+
+      op_SLL:
+	registers[rdReg] = registers[rtReg] << ip->extra;
+	goto retire;
+
+      op_SLLV:
+	registers[rdReg] = registers[rtReg] << (registers[rsReg] & 0x1f);
+	goto retire;
+
+      op_SLT:
+	registers[rdReg] = (registers[rsReg] < registers[rtReg]) ? 1 : 0;
+	goto retire;
+
+      op_SLTI:
+	registers[rtReg] = (registers[rsReg] < ip->extra) ? 1 : 0;
+	goto retire;
+
+      op_SLTIU:
+	rs = registers[rsReg];
+	imm = ip->extra;
+	registers[rtReg] = (rs < imm) ? 1 : 0;
+	goto retire;
+
+      op_SLTU:
+	rs = registers[rsReg];
+	rt = registers[rtReg];
+	registers[rdReg] = (rs < rt) ? 1 : 0;
+	goto retire;
+
+      op_SRA:
+	registers[rdReg] = registers[rtReg] >> ip->extra;
+	goto retire;
+
+      op_SRAV:
+	registers[rdReg] = registers[rtReg] >> (registers[rsReg] & 0x1f);
+	goto retire;
+
+      op_SRL:
+	tmp = registers[rtReg];
+	tmp >>= ip->extra;
+	registers[rdReg] = tmp;
+	goto retire;
+
+      op_SRLV:
+	tmp = registers[rtReg];
+	tmp >>= (registers[rsReg] & 0x1f);
+	registers[rdReg] = tmp;
+	goto retire;
+
+      op_SUB:
+	diff = registers[rsReg] - registers[rtReg];
+	if (((registers[rsReg] ^ registers[rtReg]) & SIGN_BIT) &&
+	    ((registers[rsReg] ^ diff) & SIGN_BIT)) {
+	    RaiseException(OverflowException, 0);
+	    goto trapped;
+	}
+	registers[rdReg] = diff;
+	goto retire;
+
+      op_SUBU:
+	registers[rdReg] = registers[rsReg] - registers[rtReg];
+	goto retire;
+
+      op_SW:
+	if (!WriteMem((unsigned) 
+		(registers[rsReg] + ip->extra), 4, registers[rtReg]))
+	    goto trapped;
+	goto retire;
+
+      op_XOR:
+	registers[rdReg] = registers[rsReg] ^ registers[rtReg];
+	goto retire;
+
+      op_XORI:
+	registers[rtReg] = registers[rsReg] ^ (ip->extra & 0xffff);
+	goto retire;
+
+      retire:
+	// Same bookkeeping as the end of OneInstruction, plus the tick
+	// that OneTick would have charged; no interrupt can be due yet.
+	DelayedLoad(nextLoadReg, nextLoadValue);
+	registers[PrevPCReg] = registers[PCReg];
+	registers[PCReg] = registers[NextPCReg];
+	registers[NextPCReg] = pcAfter;
+	stats->totalTicks += UserTick;
+	stats->userTicks += UserTick;
+	budget--;
+
+      next:
+	if (budget > 0 && !(registers[PCReg] & 0x3)
+	      && !((registers[PCReg] ^ blockPC) & ~(PageSize - 1)))
+	    goto dispatch;
+	continue;
+
+      trapped:
+	// The instruction raised an exception, which the kernel has now
+	// handled; as in Run, the attempt still costs a tick.
+	interrupt->OneTick();
+	continue;
+
+      op_reference:
+      reference:
+	OneInstruction(instr);
+	interrupt->OneTick();
+    }
+}
+
 //----------------------------------------------------------------------
 // TypeToReg
 // 	Retrieve the register # referred to in an instruction. 
@@ -127,16 +726,13 @@ Machine::OneInstruction(Instruction *instr)
     int byte;       // described in Kane for LWL,LWR,...
 #endif
 
-    int raw;
     int nextLoadReg = 0; 	
     int nextLoadValue = 0; 	// record delayed load operation, to apply
 				// in the future
 
     // Fetch instruction 
-    if (!ReadMem(registers[PCReg], 4, &raw))
+    if (!FetchInstruction(instr))
 	return;			// exception occurred
-    instr->value = raw;
-    instr->Decode();
 
     if (debug->IsEnabled('m')) {
         struct OpString *str = &opStrings[instr->opCode];
@@ -671,6 +1267,9 @@ Machine::OneInstruction(Instruction *instr)
 	break;
     	
       case OP_SYSCALL:
+	if (profile != NULL)
+	    profile->Count(registers[PCReg], registers[NextPCReg], pcAfter,
+			   instr);
 	DEBUG(dbgTraCode, "In Machine::OneInstruction, RaiseException(SyscallException, 0), " << kernel->stats->totalTicks);
 	RaiseException(SyscallException, 0);
 	return; 
@@ -694,6 +1293,9 @@ Machine::OneInstruction(Instruction *instr)
     
     // Now we have successfully executed the instruction.
     
+    if (profile != NULL)
+	profile->Count(registers[PCReg], registers[NextPCReg], pcAfter, instr);
+
     // Do any delayed load operation
     DelayedLoad(nextLoadReg, nextLoadValue);
     
@@ -704,6 +1306,85 @@ Machine::OneInstruction(Instruction *instr)
     registers[NextPCReg] = pcAfter;
 }
 
+//----------------------------------------------------------------------
+// Machine::FetchInstruction
+// 	Fetch the instruction at PCReg into "instr", already decoded.
+//
+//	The address still goes through the soft TLB, or Translate, on
+//	every fetch, so that page faults, the use bit and alignment are
+//	handled exactly as for ReadMem.  Only the decoding is cached, keyed
+//	by physical address, so a hot loop decodes each of its instructions
+//	once.
+//
+//	Returns FALSE if the fetch raised an exception.
+//----------------------------------------------------------------------
+
+bool
+Machine::FetchInstruction(Instruction *instr)
+{
+    int addr = registers[PCReg];
+    int physicalAddress;
+    ExceptionType exception;
+    char *host = SoftTranslate(addr, 4, SoftRead);
+
+    if (host != NULL)
+	physicalAddress = host - mainMemory;
+    else {
+	exception = Translate(addr, &physicalAddress, 4, FALSE);
+	if (exception != NoException) {
+	    RaiseException(exception, addr);
+	    return FALSE;
+	}
+    }
+    if (icache != NULL)
+	CacheReference(icache, physicalAddress, FALSE);
+
+    *instr = *Predecode(physicalAddress / 4);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::Predecode
+// 	Return the decoded form of word "slot" of mainMemory, from the
+//	predecode cache, decoding the word first if it is not there.
+//----------------------------------------------------------------------
+
+Instruction *
+Machine::Predecode(int slot)
+{
+    if (!decodeValid[slot]) {
+	decodeCache[slot].value =
+		WordToHost(*(unsigned int *) &mainMemory[slot * 4]);
+	decodeCache[slot].Decode();
+	decodeValid[slot] = TRUE;
+	decodedPage[slot / (PageSize / 4)] = TRUE;
+    }
+    return &decodeCache[slot];
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateDecodedPage
+// 	Drop the predecoded instructions held for one physical page,
+//	because its contents have changed (or are about to).
+//
+//	"pageFrame" -- the physical page number
+//----------------------------------------------------------------------
+
+void
+Machine::InvalidateDecodedPage(int pageFrame)
+{
+    ASSERT((pageFrame >= 0) && (pageFrame < NumPhysPages));
+    if (decodedPage[pageFrame]) {
+	bzero(&decodeValid[pageFrame * (PageSize / 4)],
+	      (PageSize / 4) * sizeof(bool));
+	bzero(&threadedCode[pageFrame * (PageSize / 4)],
+	      (PageSize / 4) * sizeof(void *));
+	if (jit != NULL)
+	    jit->Invalidate(pageFrame * (PageSize / 4), PageSize / 4);
+	decodedPage[pageFrame] = FALSE;
+    }
+}
+
 //----------------------------------------------------------------------
 // Machine::DelayedLoad
 // 	Simulate effects of a delayed load.
@@ -11,6 +11,7 @@
 #include "copyright.h"
 #include "network.h"
 #include "main.h"
+#include "eventlog.h"
 
 //-----------------------------------------------------------------------
 // NetworkInput::NetworkInput
@@ -53,7 +54,8 @@ NetworkInput::~NetworkInput()
 //	be read in from the simulated network.
 //
 //      First check to make sure packet is available & there's space to
-//	pull it in.  Then invoke the "callBack" registered by whoever 
+//	pull it in (when replaying, the packet comes from the event log).
+//	Then invoke the "callBack" registered by whoever 
 //	wants the packet.
 //-----------------------------------------------------------------------
 
@@ -65,12 +67,27 @@ NetworkInput::CallBack()
 
     if (inHdr.length != 0) 	// do nothing if packet is already buffered
 	return;		
-    if (!PollSocket(sock)) 	// do nothing if no packet to be read
-	return;
 
-    // otherwise, read packet in
+    EventLog *log = kernel->eventLog;
     char *buffer = new char[MaxWireSize];
-    ReadFromSocket(sock, buffer, MaxWireSize);
+
+    if (log != NULL && log->IsReplaying()) {	// the log has the packets
+	if (log->Replay(LogNetwork, kernel->stats->totalTicks, buffer) < 0) {
+	    delete [] buffer;
+	    return;
+	}
+    } else {
+	if (!PollSocket(sock)) {	// do nothing if no packet to be read
+	    delete [] buffer;
+	    return;
+	}
+
+	// otherwise, read packet in
+	ReadFromSocket(sock, buffer, MaxWireSize);
+	if (log != NULL)
+	    log->Record(LogNetwork, kernel->stats->totalTicks, buffer,
+			sizeof(PacketHeader) + ((PacketHeader *)buffer)->length);
+    }
 
     // divide packet into header and data
     inHdr = *(PacketHeader *)buffer;
@@ -0,0 +1,270 @@
+// pagetable.cc
+//	Routines to find, make and drop the entries of a page table.
+//	See pagetable.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pagetable.h"
+#include "main.h"
+
+// An entry of a hashed table, on the chain of its bucket
+
+class HashedEntry {
+  public:
+    int space;				// whose page
+    unsigned int vpn;			// which page
+    TranslationEntry entry;
+    HashedEntry *next;
+};
+
+// The hashed table: one bucket for each frame of physical memory,
+// since about that many entries are in it at once
+
+#define NumBuckets	NumPhysPages
+
+static HashedEntry **buckets = NULL;
+static int nextSpace = 0;		// the key of the next table made
+
+#define Bucket(space, vpn)	((((unsigned) (space) * 0x9E3779B1U) ^ (vpn)) \
+				    % NumBuckets)
+
+//----------------------------------------------------------------------
+// PageTable::PageTable
+// 	Initialize a page table for an address space of "numPages"
+//	pages, none of them there yet.  A linear table has all its
+//	entries already, invalid.
+//----------------------------------------------------------------------
+
+PageTable::PageTable(PageTableKind kind, int numPages)
+{
+    this->kind = kind;
+    this->numPages = numPages;
+    linear = NULL;
+    directory = NULL;
+    space = nextSpace++;
+    switch (kind) {
+      case LinearTable:
+	linear = new TranslationEntry[numPages];
+	for (int i = 0; i < numPages; i++) {
+	    linear[i].virtualPage = i;
+	    linear[i].physicalPage = 0;
+	    linear[i].valid = FALSE;
+	    linear[i].readOnly = FALSE;
+	    linear[i].use = FALSE;
+	    linear[i].dirty = FALSE;
+	}
+	Charge(numPages * sizeof(TranslationEntry));
+	break;
+      case TwoLevelTable:
+	directory = new TranslationEntry *[divRoundUp(numPages, TwoLevelLeafPages)];
+	for (int i = 0; i < divRoundUp(numPages, TwoLevelLeafPages); i++)
+	    directory[i] = NULL;
+	Charge(divRoundUp(numPages, TwoLevelLeafPages) * sizeof(TranslationEntry *));
+	break;
+      case HashedTable:
+	if (buckets == NULL) {		// the first one: there for good
+	    buckets = new HashedEntry *[NumBuckets];
+	    for (int i = 0; i < NumBuckets; i++)
+		buckets[i] = NULL;
+	    Charge(NumBuckets * sizeof(HashedEntry *));
+	}
+	break;
+    }
+}
+
+//----------------------------------------------------------------------
+// PageTable::~PageTable
+// 	De-allocate a page table, and all its entries.
+//----------------------------------------------------------------------
+
+PageTable::~PageTable()
+{
+    switch (kind) {
+      case LinearTable:
+	delete [] linear;
+	Charge(-numPages * (int) sizeof(TranslationEntry));
+	break;
+      case TwoLevelTable:
+	for (int i = 0; i < divRoundUp(numPages, TwoLevelLeafPages); i++) {
+	    if (directory[i] != NULL) {
+		delete [] directory[i];
+		Charge(-TwoLevelLeafPages * (int) sizeof(TranslationEntry));
+	    }
+	}
+	delete [] directory;
+	Charge(-divRoundUp(numPages, TwoLevelLeafPages) * (int) sizeof(TranslationEntry *));
+	break;
+      case HashedTable:
+	for (int i = 0; i < numPages; i++)
+	    Remove(i);
+	break;
+    }
+}
+
+//----------------------------------------------------------------------
+// PageTable::Walk
+// 	Return the entry for page "vpn", or NULL if there is none, and
+//	count the lookup and its memory references.  The machine calls
+//	this on every translation it does not find in its soft TLB, and
+//	the kernel on every TLB miss.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+PageTable::Walk(unsigned int vpn)
+{
+    int probes = 0;
+    TranslationEntry *entry = Probe(vpn, &probes);
+
+    kernel->stats->numPageTableWalks++;
+    kernel->stats->numPageTableProbes += probes;
+    return entry;
+}
+
+//----------------------------------------------------------------------
+// PageTable::Find
+// 	Return the entry for page "vpn", or NULL if there is none.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+PageTable::Find(unsigned int vpn)
+{
+    int probes;
+
+    return Probe(vpn, &probes);
+}
+
+//----------------------------------------------------------------------
+// PageTable::Probe
+// 	Return the entry for page "vpn", or NULL if there is none, and
+//	add the memory references it took to find out to "*probes".
+//----------------------------------------------------------------------
+
+TranslationEntry *
+PageTable::Probe(unsigned int vpn, int *probes)
+{
+    HashedEntry *e;
+
+    ASSERT(vpn < (unsigned) numPages);
+    switch (kind) {
+      case LinearTable:
+	*probes += 1;
+	return &linear[vpn];
+      case TwoLevelTable:
+	*probes += 1;
+	if (directory[vpn / TwoLevelLeafPages] == NULL)
+	    return NULL;
+	*probes += 1;
+	return &directory[vpn / TwoLevelLeafPages][vpn % TwoLevelLeafPages];
+      case HashedTable:
+	*probes += 1;			// the bucket, or its first entry
+	for (e = buckets[Bucket(space, vpn)]; e != NULL; e = e->next) {
+	    if (e->space == space && e->vpn == vpn)
+		return &e->entry;
+	    if (e->next != NULL)
+		*probes += 1;
+	}
+	return NULL;
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// PageTable::Entry
+// 	Return the entry for page "vpn", making it if there is none yet:
+//	a new entry is invalid, and maps the page to frame 0.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+PageTable::Entry(unsigned int vpn)
+{
+    TranslationEntry *entry = Find(vpn);
+    TranslationEntry *leaf;
+    HashedEntry *e;
+
+    if (entry != NULL)
+	return entry;
+    switch (kind) {
+      case LinearTable:
+	ASSERTNOTREACHED();		// they are all there
+	break;
+      case TwoLevelTable:
+	leaf = new TranslationEntry[TwoLevelLeafPages];
+	directory[vpn / TwoLevelLeafPages] = leaf;
+	Charge(TwoLevelLeafPages * sizeof(TranslationEntry));
+	for (int i = 0; i < TwoLevelLeafPages; i++) {
+	    leaf[i].virtualPage = vpn / TwoLevelLeafPages * TwoLevelLeafPages + i;
+	    leaf[i].physicalPage = 0;
+	    leaf[i].valid = FALSE;
+	    leaf[i].readOnly = FALSE;
+	    leaf[i].use = FALSE;
+	    leaf[i].dirty = FALSE;
+	}
+	entry = &leaf[vpn % TwoLevelLeafPages];
+	break;
+      case HashedTable:
+	e = new HashedEntry;
+	e->space = space;
+	e->vpn = vpn;
+	e->next = buckets[Bucket(space, vpn)];
+	buckets[Bucket(space, vpn)] = e;
+	Charge(sizeof(HashedEntry));
+	entry = &e->entry;
+	entry->virtualPage = vpn;
+	entry->physicalPage = 0;
+	entry->valid = FALSE;
+	entry->readOnly = FALSE;
+	entry->use = FALSE;
+	entry->dirty = FALSE;
+	break;
+    }
+    return entry;
+}
+
+//----------------------------------------------------------------------
+// PageTable::Remove
+// 	Page "vpn" has no frame any more: invalidate its entry, and, in
+//	a hashed table, drop it.  A leaf of a two-level table stays,
+//	even if none of its pages are left: the stack and the heap soon
+//	grow back into it.
+//----------------------------------------------------------------------
+
+void
+PageTable::Remove(unsigned int vpn)
+{
+    HashedEntry **prev, *e;
+    TranslationEntry *entry;
+
+    if (kind != HashedTable) {
+	if ((entry = Find(vpn)) != NULL)
+	    entry->valid = FALSE;
+	return;
+    }
+    for (prev = &buckets[Bucket(space, vpn)]; (e = *prev) != NULL;
+	 prev = &e->next) {
+	if (e->space == space && e->vpn == vpn) {
+	    *prev = e->next;
+	    delete e;
+	    Charge(-(int) sizeof(HashedEntry));
+	    return;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// PageTable::Charge
+// 	Add "bytes" (which may be negative) to the bytes that all the
+//	page tables take, and keep track of the most they have taken.
+//----------------------------------------------------------------------
+
+void
+PageTable::Charge(int bytes)
+{
+    Statistics *stats = kernel->stats;
+
+    stats->pageTableBytes += bytes;
+    if (stats->pageTableBytes > stats->peakPageTableBytes)
+	stats->peakPageTableBytes = stats->pageTableBytes;
+}
@@ -0,0 +1,80 @@
+// pagetable.h
+//	Data structures for the page table of an address space: where
+//	the machine (see Machine::Translate), or the kernel refilling
+//	the TLB, finds the translation for a virtual page.
+//
+//	A page table comes in one of three shapes:
+//
+//	A linear table is an array of translation entries, one for every
+//	page of the address space, whether the page is there or not.
+//	Finding an entry takes one memory reference.
+//
+//	A two-level table is a directory with a pointer for each run of
+//	TwoLevelLeafPages pages, to a leaf table of their entries.  Only
+//	the leaves for runs with pages in them are there, so the room
+//	left between the heap and the stack costs a directory slot per
+//	run, not an entry per page.  Finding an entry takes two memory
+//	references.
+//
+//	A hashed table has entries only for the pages that are there,
+//	in one hash table shared by all address spaces, keyed by
+//	(address space, virtual page) and chained on collisions; like
+//	an inverted page table, its size goes with physical memory, not
+//	with the address spaces.  Finding an entry takes one memory
+//	reference per entry on the chain up to it.
+//
+//	The statistics count each lookup the machine makes (a walk), the
+//	memory references it takes (probes), and how many bytes all the
+//	page tables take, at the most.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PAGETABLE_H
+#define PAGETABLE_H
+
+#include "copyright.h"
+#include "translate.h"
+
+#define TwoLevelLeafPages	32	// pages per leaf of a two-level table
+
+enum PageTableKind { LinearTable, TwoLevelTable, HashedTable };
+
+class HashedEntry;
+
+class PageTable {
+  public:
+    PageTable(PageTableKind kind, int numPages);
+					// A table with no pages in it
+    ~PageTable();
+
+    TranslationEntry *Walk(unsigned int vpn);
+					// Find the entry for page "vpn", as
+					// the machine does, counting the
+					// probes; NULL if there is none
+    TranslationEntry *Find(unsigned int vpn);
+					// The same, for the kernel: not
+					// counted
+    TranslationEntry *Entry(unsigned int vpn);
+					// The entry for page "vpn", made
+					// (invalid) if there is none yet
+    void Remove(unsigned int vpn);	// Page "vpn" is no longer there;
+					// its entry may go
+
+  private:
+    PageTableKind kind;
+    int numPages;			// # of pages in the address space
+    int space;				// with a hashed table, our part of
+					// the key
+    TranslationEntry *linear;		// a linear table
+    TranslationEntry **directory;	// a two-level table: leaves, NULL
+					// if none
+
+    TranslationEntry *Probe(unsigned int vpn, int *probes);
+					// Find, counting the probes
+    void Charge(int bytes);		// Account for "bytes" more (or
+					// fewer) bytes of page tables
+};
+
+#endif // PAGETABLE_H
@@ -0,0 +1,415 @@
+// profile.cc
+//	Routines to profile the execution of a user program.  See
+//	profile.h for what we count.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "profile.h"
+#include "machine.h"
+#include "mipssim.h"
+#include "sysdep.h"
+
+// A node of the calling context tree: the routine at "entry", called
+// through the chain of routines from the root down to "parent".
+
+class CallNode {
+  public:
+    CallNode(int entry, CallNode *up);
+    ~CallNode();
+
+    CallNode *Callee(int entry);	// the node for a call to "entry"
+					// from here; created if need be
+
+    int function;			// entry address of the routine
+    int count;				// # of instructions executed here
+    CallNode *parent;
+    CallNode *children;			// routines called from here
+    CallNode *sibling;			// the next child of our parent
+};
+
+//----------------------------------------------------------------------
+// CallNode::CallNode, CallNode::~CallNode
+// 	Create a context for the routine at "entry", called from "up",
+//	or delete it, and everything called from it.
+//----------------------------------------------------------------------
+
+CallNode::CallNode(int entry, CallNode *up)
+{
+    function = entry;
+    count = 0;
+    parent = up;
+    children = NULL;
+    sibling = NULL;
+}
+
+CallNode::~CallNode()
+{
+    CallNode *next;
+
+    for (CallNode *child = children; child != NULL; child = next) {
+	next = child->sibling;
+	delete child;
+    }
+}
+
+//----------------------------------------------------------------------
+// CallNode::Callee
+// 	Return the context for a call from here to the routine at
+//	"entry", creating it the first time.
+//----------------------------------------------------------------------
+
+CallNode *
+CallNode::Callee(int entry)
+{
+    CallNode *child;
+
+    for (child = children; child != NULL; child = child->sibling) {
+	if (child->function == entry)
+	    return child;
+    }
+    child = new CallNode(entry, this);
+    child->sibling = children;
+    children = child;
+    return child;
+}
+
+//----------------------------------------------------------------------
+// Profile::Profile
+// 	Start counting the instructions of a program, and load its
+//	symbol table, if there is one.
+//
+//	"programName" is the file the program was loaded from
+//	"codeStart", "codeSize" tell where its code segment is
+//----------------------------------------------------------------------
+
+Profile::Profile(char *programName, int codeStart, int codeSize)
+{
+    name = new char[strlen(programName) + 1];
+    strcpy(name, programName);
+    start = codeStart;
+    numWords = divRoundUp(codeSize, 4);
+    executed = new int[numWords];
+    taken = new int[numWords];
+    loads = new int[numWords];
+    stores = new int[numWords];
+    for (int i = 0; i < numWords; i++)
+	executed[i] = taken[i] = loads[i] = stores[i] = 0;
+    numBranches = 0;
+    outside = 0;
+
+    numSymbols = 0;
+    symbolAddr = NULL;
+    symbolName = NULL;
+    ReadSymbols();
+
+    root = new CallNode(codeStart, NULL);	// the program starts at the
+    current = root;				// start of its code
+    callTarget = -1;
+    returning = FALSE;
+}
+
+//----------------------------------------------------------------------
+// Profile::~Profile
+// 	De-allocate the counters and the symbol table.
+//----------------------------------------------------------------------
+
+Profile::~Profile()
+{
+    delete [] name;
+    delete [] executed;
+    delete [] taken;
+    delete [] loads;
+    delete [] stores;
+    for (int i = 0; i < numSymbols; i++)
+	delete [] symbolName[i];
+    delete [] symbolAddr;
+    delete [] symbolName;
+    delete root;
+}
+
+//----------------------------------------------------------------------
+// Profile::ReadSymbols
+// 	Load the symbol table coff2noff wrote next to the program, if
+//	there is one.  See profile.h for its format.
+//----------------------------------------------------------------------
+
+void
+Profile::ReadSymbols()
+{
+    char *fileName = new char[strlen(name) + 5];
+    char *text, *p, *end;
+    int fd, size, length;
+
+    sprintf(fileName, "%s.sym", name);
+    fd = OpenForReadWrite(fileName, FALSE);
+    delete [] fileName;
+    if (fd < 0)
+	return;
+
+    Lseek(fd, 0, 2);
+    size = Tell(fd);
+    Lseek(fd, 0, 0);
+    text = new char[size + 1];
+    Read(fd, text, size);
+    text[size] = '\0';
+    Close(fd);
+
+    symbolAddr = new int[size / 4 + 1];		// each line is at least that
+    symbolName = new char *[size / 4 + 1];	// long
+    for (p = text; *p != '\0'; p++) {
+	symbolAddr[numSymbols] = (int) strtoul(p, &end, 16);
+	if (end == p || (*end != ' ' && *end != '\t'))
+	    break;				// not a symbol table
+	for (p = end; *p == ' ' || *p == '\t'; p++)
+	    ;
+	for (length = 0; p[length] != '\0' && p[length] != '\n'; length++)
+	    ;
+	symbolName[numSymbols] = new char[length + 1];
+	strncpy(symbolName[numSymbols], p, length);
+	symbolName[numSymbols][length] = '\0';
+	numSymbols++;
+	p += length;
+	if (*p == '\0')
+	    break;
+    }
+    delete [] text;
+}
+
+//----------------------------------------------------------------------
+// Profile::FindSymbol
+// 	Return the index of the last symbol at or before "addr", or -1
+//	if there is none.
+//----------------------------------------------------------------------
+
+int
+Profile::FindSymbol(int addr)
+{
+    int low = 0, high = numSymbols - 1, mid;
+
+    while (low <= high) {			// binary search
+	mid = (low + high) / 2;
+	if (symbolAddr[mid] <= addr)
+	    low = mid + 1;
+	else
+	    high = mid - 1;
+    }
+    return high;
+}
+
+//----------------------------------------------------------------------
+// Profile::AddrName
+// 	Put a printable name for "addr" into "buf", of "size" bytes, and
+//	return it: "symbol", or "symbol+offset", or failing that, the
+//	address.  A symbol too long for "buf" is cut short.
+//----------------------------------------------------------------------
+
+char *
+Profile::AddrName(int addr, char *buf, int size)
+{
+    int i = FindSymbol(addr);
+
+    if (i < 0)
+	snprintf(buf, size, "0x%x", addr);
+    else if (symbolAddr[i] == addr)
+	snprintf(buf, size, "%s", symbolName[i]);
+    else
+	snprintf(buf, size, "%s+0x%x", symbolName[i], addr - symbolAddr[i]);
+    return buf;
+}
+
+//----------------------------------------------------------------------
+// Profile::Count
+// 	Count one execution of the instruction "instr" at "pc".
+//
+//	A call or a return changes the context only after its delay
+//	slot, since the delay slot is still executed by the caller, or
+//	by the routine returning.
+//
+//	"nextPC" is the address of the next instruction
+//	"pcAfter" is where execution continues after that
+//----------------------------------------------------------------------
+
+void
+Profile::Count(int pc, int nextPC, int pcAfter, Instruction *instr)
+{
+    int word = (pc - start) / 4;
+    bool branch = FALSE, load = FALSE, store = FALSE;
+
+    switch (instr->opCode) {
+      case OP_BEQ: case OP_BGEZ: case OP_BGEZAL: case OP_BGTZ:
+      case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL: case OP_BNE:
+      case OP_J: case OP_JAL: case OP_JALR: case OP_JR:
+	branch = TRUE;
+	numBranches++;
+	break;
+      case OP_LB: case OP_LBU: case OP_LH: case OP_LHU:
+      case OP_LW: case OP_LWL: case OP_LWR:
+	load = TRUE;
+	break;
+      case OP_SB: case OP_SH: case OP_SW: case OP_SWL: case OP_SWR:
+	store = TRUE;
+	break;
+    }
+
+    if (pc >= start && word < numWords) {
+	executed[word]++;
+	if (branch && pcAfter != nextPC + 4)
+	    taken[word]++;
+	if (load)
+	    loads[word]++;
+	if (store)
+	    stores[word]++;
+    } else {
+	outside++;
+    }
+    current->count++;
+
+    if (callTarget != -1) {		// we were a call's delay slot
+	current = current->Callee(callTarget);
+	callTarget = -1;
+    } else if (returning) {		// we were a return's delay slot
+	if (current->parent != NULL)
+	    current = current->parent;
+	returning = FALSE;
+    }
+
+    switch (instr->opCode) {
+      case OP_JAL: case OP_JALR:
+	callTarget = pcAfter;
+	break;
+      case OP_BGEZAL: case OP_BLTZAL:
+	if (pcAfter != nextPC + 4)
+	    callTarget = pcAfter;
+	break;
+      case OP_JR:
+	returning = (instr->rs == RetAddrReg);
+	break;
+    }
+}
+
+//----------------------------------------------------------------------
+// Profile::Report
+// 	Print the totals, the ProfileHotSpots instructions executed most
+//	often, and, if we have symbols, the time spent in each routine.
+//	Then write the calling context tree out as folded stacks, to
+//	"<program>.<processId>.folded", so that copies of a program that
+//	run at the same time each get a file of their own.
+//----------------------------------------------------------------------
+
+void
+Profile::Report(int processId)
+{
+    int hot[ProfileHotSpots];
+    int numHot = 0, total = outside, totalTaken = 0;
+    int totalLoads = 0, totalStores = 0;
+    char line[200], where[100], *fileName;
+    int i, j, fd;
+
+    for (i = 0; i < numWords; i++) {
+	total += executed[i];
+	totalTaken += taken[i];
+	totalLoads += loads[i];
+	totalStores += stores[i];
+	if (executed[i] == 0)
+	    continue;
+	// keep hot[] sorted, most executed first
+	for (j = numHot; j > 0 && executed[hot[j - 1]] < executed[i]; j--) {
+	    if (j < ProfileHotSpots)
+		hot[j] = hot[j - 1];
+	}
+	if (j < ProfileHotSpots) {
+	    hot[j] = i;
+	    if (numHot < ProfileHotSpots)
+		numHot++;
+	}
+    }
+    if (total == 0)
+	total = 1;			// keep the percentages finite
+
+    cout << "Profile of " << name << ": " << total << " instructions, "
+	 << numBranches << " branches (" << totalTaken << " taken), "
+	 << totalLoads << " loads, " << totalStores << " stores\n";
+    snprintf(line, sizeof(line), "%10s %6s  %-28s %8s %8s %8s\n", "count",
+	     "%", "address", "taken", "loads", "stores");
+    cout << line;
+    for (i = 0; i < numHot; i++) {
+	j = hot[i];
+	snprintf(line, sizeof(line), "%10d %6.2f  %-28s %8d %8d %8d\n",
+		 executed[j], 100.0 * executed[j] / total,
+		 AddrName(start + j * 4, where, sizeof(where)),
+		 taken[j], loads[j], stores[j]);
+	cout << line;
+    }
+
+    if (numSymbols > 0) {
+	int *perSymbol = new int[numSymbols];
+	int best;
+
+	for (i = 0; i < numSymbols; i++)
+	    perSymbol[i] = 0;
+	for (i = 0; i < numWords; i++) {
+	    j = FindSymbol(start + i * 4);
+	    if (j >= 0)
+		perSymbol[j] += executed[i];
+	}
+	snprintf(line, sizeof(line), "%10s %6s  %s\n", "count", "%", "routine");
+	cout << line;
+	for (;;) {			// print them, most executed first
+	    best = 0;
+	    for (i = 1; i < numSymbols; i++) {
+		if (perSymbol[i] > perSymbol[best])
+		    best = i;
+	    }
+	    if (perSymbol[best] == 0)
+		break;
+	    snprintf(line, sizeof(line), "%10d %6.2f  %s\n", perSymbol[best],
+		     100.0 * perSymbol[best] / total, symbolName[best]);
+	    cout << line;
+	    perSymbol[best] = 0;
+	}
+	delete [] perSymbol;
+    }
+    cout.flush();			// we may never halt
+
+    fileName = new char[strlen(name) + 20];
+    sprintf(fileName, "%s.%d.folded", name, processId);
+    fd = OpenForWrite(fileName);
+    WriteFolded(fd, root, "");
+    Close(fd);
+    delete [] fileName;
+}
+
+//----------------------------------------------------------------------
+// Profile::WriteFolded
+// 	Write a "folded stack" line for "node", if any instructions were
+//	executed in it, and then for each of the contexts it called.
+//
+//	"stack" names the routines that called "node", separated by ";"
+//----------------------------------------------------------------------
+
+void
+Profile::WriteFolded(int fd, CallNode *node, char *stack)
+{
+    char where[100], count[20];
+    char *path;
+
+    AddrName(node->function, where, sizeof(where));
+    path = new char[strlen(stack) + strlen(where) + 2];
+    if (stack[0] == '\0')
+	strcpy(path, where);
+    else
+	sprintf(path, "%s;%s", stack, where);
+
+    if (node->count > 0) {
+	sprintf(count, " %d\n", node->count);
+	WriteFile(fd, path, strlen(path));
+	WriteFile(fd, count, strlen(count));
+    }
+    for (CallNode *child = node->children; child != NULL;
+	 child = child->sibling)
+	WriteFolded(fd, child, path);
+    delete [] path;
+}
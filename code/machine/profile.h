@@ -0,0 +1,86 @@
+// profile.h
+//	Data structures to profile the execution of a user program.
+//
+//	With "-prof", every address space keeps a Profile, and the Machine
+//	counts each user instruction it executes into the Profile of the
+//	address space that is running.  For each instruction address in
+//	the code segment, we count how often it ran, how often it was a
+//	branch that was taken, and how many loads and stores it did.
+//
+//	We also follow calls and returns (JAL/JALR/BxxAL, and JR $31) to
+//	keep a calling context tree: one node per distinct chain of calls,
+//	counting the instructions executed in it.  That is all it takes to
+//	write out "folded stacks", one line per chain:
+//
+//		__start;main;Sort 1234
+//
+//	which is what flame graph tools read.
+//
+//	Addresses are reported relative to the nearest preceding symbol,
+//	if coff2noff left a symbol table next to the program: a text file
+//	"<program>.sym" with one "<hex address> <name>" line per routine,
+//	sorted by address.  Otherwise we report bare addresses.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Instruction;
+class CallNode;
+
+const int ProfileHotSpots = 20;		// # of addresses in the report
+
+class Profile {
+  public:
+    Profile(char *programName, int codeStart, int codeSize);
+					// Profile the code in [codeStart,
+					// codeStart + codeSize) of the
+					// program in file "programName"
+    ~Profile();
+
+    void Count(int pc, int nextPC, int pcAfter, Instruction *instr);
+					// Count the instruction "instr" at
+					// "pc", which was followed by the
+					// one at "nextPC" (a delay slot, if
+					// it is a branch) and then continues
+					// at "pcAfter"
+
+    void Report(int processId);		// Print the hot spots, and write the
+					// folded stacks to
+					// "<program>.<processId>.folded"
+
+  private:
+    char *name;				// the program's file name
+    int start;				// first address of the code
+    int numWords;			// # of instructions in the code
+    int *executed;			// per instruction: # of executions,
+    int *taken;				// taken branches,
+    int *loads;				// loads and
+    int *stores;			// stores
+    int numBranches;			// # of branches executed
+    int outside;			// # of instructions executed outside
+					// of the code segment
+
+    int numSymbols;			// the symbol table, if any
+    int *symbolAddr;			// sorted by address
+    char **symbolName;
+
+    CallNode *root;			// the calling context tree
+    CallNode *current;			// the context we are running in
+    int callTarget;			// where the call in the delay slot
+					// of which we are goes; -1 if none
+    bool returning;			// are we in the delay slot of a
+					// return?
+
+    void ReadSymbols();			// load "<program>.sym", if any
+    int FindSymbol(int addr);		// index of the symbol "addr" is in;
+					// -1 if none
+    char *AddrName(int addr, char *buf, int size);
+					// "symbol+offset", or the address
+    void WriteFolded(int fd, CallNode *node, char *stack);
+					// write out the stacks under "node"
+};
+
+#endif // PROFILE_H
@@ -10,6 +10,7 @@
 #include "copyright.h"
 #include "debug.h"
 #include "stats.h"
+#include "main.h"
 
 //----------------------------------------------------------------------
 // Statistics::Statistics
@@ -18,28 +19,59 @@
 
 Statistics::Statistics()
 {
-    totalTicks = idleTicks = systemTicks = userTicks = 0;
+    totalTicks = globalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numZeroFills = numZeroFramesSaved = 0;
+    numSoftTLBHits = numSoftTLBMisses = 0;
+    numTLBHits = numTLBMisses = numTLBEvictions = 0;
+    numPageTableWalks = numPageTableProbes = 0;
+    pageTableBytes = peakPageTableBytes = 0;
+    numICacheHits = numICacheMisses = numDCacheHits = numDCacheMisses = 0;
+    cacheStallTicks = 0;
 }
 
 //----------------------------------------------------------------------
 // Statistics::Print
 // 	Print performance metrics, when we've finished everything
-//	at system shutdown.
+//	at system shutdown.  The counters of the features that are off
+//	(and of the soft TLB, unless -stlb asks for them) are left out,
+//	so that by default the output is as it always was.
 //----------------------------------------------------------------------
 
 void
 Statistics::Print()
 {
-    cout << "Ticks: total " << totalTicks << ", idle " << idleTicks;
+    cout << "Ticks: total " << GlobalTicks() << ", idle " << idleTicks;
 		cout << ", system " << systemTicks << ", user " << userTicks <<"\n";
     cout << "Disk I/O: reads " << numDiskReads;
 		cout << ", writes " << numDiskWrites << "\n";
 		cout << "Console I/O: reads " << numConsoleCharsRead;
     cout << ", writes " << numConsoleCharsWritten << "\n";
     cout << "Paging: faults " << numPageFaults << "\n";
+    if (kernel->zeroFrame >= 0) {
+	cout << "Zero fill: fills " << numZeroFills;
+	cout << ", frames saved " << numZeroFramesSaved << "\n";
+    }
+    if (kernel->softTLBStats) {
+	cout << "Soft TLB: hits " << numSoftTLBHits;
+	cout << ", misses " << numSoftTLBMisses << "\n";
+    }
+    if (kernel->machine->tlb != NULL) {
+	cout << "TLB: hits " << numTLBHits << ", misses " << numTLBMisses;
+	cout << ", evictions " << numTLBEvictions << "\n";
+    }
+    if (kernel->pageTableKind != LinearTable) {
+	cout << "Page tables: walks " << numPageTableWalks;
+	cout << ", probes " << numPageTableProbes;
+	cout << ", peak bytes " << peakPageTableBytes << "\n";
+    }
+    if (kernel->machine->icache != NULL || kernel->machine->dcache != NULL) {
+	cout << "Caches: I hits " << numICacheHits << ", misses " << numICacheMisses;
+	cout << "; D hits " << numDCacheHits << ", misses " << numDCacheMisses;
+	cout << "; stall " << cacheStallTicks << "\n";
+    }
     cout << "Network I/O: packets received " << numPacketsRecvd;
 		cout << ", sent " << numPacketsSent << "\n";
 }
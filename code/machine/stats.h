@@ -21,23 +21,57 @@
 
 class Statistics {
   public:
-    int totalTicks;      	// Total time running Nachos
+    int totalTicks;      	// Total time running Nachos; with
+				// several CPUs, the clock of the one
+				// being simulated, which the others
+				// may be ahead of
+    int globalTicks;		// with several CPUs, the clock of the
+				// one furthest ahead when we last
+				// switched CPUs
     int idleTicks;       	// Time spent idle (no threads to run)
     int systemTicks;	 	// Time spent executing system code
     int userTicks;       	// Time spent executing user code
 				// (this is also equal to # of
-				// user instructions executed)
+				// user instructions executed,
+				// plus cacheStallTicks)
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
+    int numZeroFills;		// number of zero-fill pages given a frame
+				// of their own when first written (-zf)
+    int numZeroFramesSaved;	// number of zero-fill pages that never
+				// were, when their programs exited
+    int numSoftTLBHits;		// number of translations found in the
+    int numSoftTLBMisses;	// simulator's soft TLB, and not found
+    int numTLBHits;		// number of translations found in the TLB
+    int numTLBMisses;		// number of TLB misses refilled by the kernel
+    int numTLBEvictions;	// number of valid TLB entries replaced
+    int numPageTableWalks;	// number of page table lookups by the
+    int numPageTableProbes;	// machine, and the memory references
+				// they took (see pagetable.h)
+    int pageTableBytes;		// bytes all page tables take now, and
+    int peakPageTableBytes;	// the most they took at once
+    int numICacheHits;		// number of instruction fetches, and of
+    int numICacheMisses;	// loads and stores, that hit or missed
+    int numDCacheHits;		// in the simulated caches
+    int numDCacheMisses;
+    int cacheStallTicks;	// user time spent waiting for the caches
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
 
     Statistics(); 		// initialize everything to zero
 
+    int GlobalTicks() { return totalTicks > globalTicks ? totalTicks
+				: globalTicks; }
+				// The time of the CPU furthest ahead:
+				// unlike totalTicks, it never goes back
+				// when we switch CPUs, so the scheduler
+				// uses it to time threads, which may
+				// move between CPUs
+
     void Print();		// print collected statistics
 };
 
@@ -56,5 +90,8 @@ const int SeekTime =	 500;  	// time disk takes to seek past one track
 const int ConsoleTime =	 1;	// [ADD MP3] spec instruction 2.; time to read or write one character
 const int NetworkTime =	 100;  	// time to send or receive one packet
 const int TimerTicks = 	 100;  	// (average) time between timer interrupts
+const int TLBMissTicks =  20;	// time for the kernel to refill the TLB
+const int CacheMissTicks = 10;	// time to move a cache line to or from memory
+const int CacheWriteTicks = 2;	// time to write one word through to memory
 
 #endif // STATS_H
@@ -22,6 +22,7 @@
 #include "copyright.h"
 #include "timer.h"
 #include "main.h"
+#include "eventlog.h"
 #include "sysdep.h"
 
 //----------------------------------------------------------------------
@@ -33,12 +34,14 @@
 //      "doRandom" -- if true, arrange for the interrupts to occur
 //		at random, instead of fixed, intervals.
 //      "toCall" is the interrupt handler to call when the timer expires.
+//      "cpuNum" is the CPU to interrupt, on a multiprocessor.
 //----------------------------------------------------------------------
 
-Timer::Timer(bool doRandom, CallBackObj *toCall)
+Timer::Timer(bool doRandom, CallBackObj *toCall, int cpuNum)
 {
     randomize = doRandom;
     callPeriodically = toCall;
+    cpu = cpuNum;
     disable = FALSE;
     SetInterrupt();
 }
@@ -63,7 +66,7 @@ Timer::CallBack()
 // Timer::SetInterrupt
 //      Cause a timer interrupt to occur in the future, unless
 //	future interrupts have been disabled.  The delay is either
-//	fixed or random.
+//	fixed or random; random ones go in the event log, if any.
 //----------------------------------------------------------------------
 
 void
@@ -73,9 +76,17 @@ Timer::SetInterrupt()
        int delay = TimerTicks;
     
        if (randomize) {
+	     EventLog *log = kernel->eventLog;
+
+	     // draw the number even when replaying, so that the others
+	     // drawn from RandomNumber stay the same
 	     delay = 1 + (RandomNumber() % (TimerTicks * 2));
+	     if (log != NULL && log->IsReplaying())
+		 (void) log->Replay(LogTimer, 0, (char *) &delay);
+	     else if (log != NULL)
+		 log->Record(LogTimer, 0, (char *) &delay, sizeof(int));
         }
        // schedule the next timer device interrupt
-       kernel->interrupt->Schedule(this, delay, TimerInt);
+       kernel->interrupt->Schedule(this, delay, TimerInt, cpu);
     }
 }
@@ -27,9 +27,9 @@
 // The following class defines a hardware timer. 
 class Timer : public CallBackObj {
   public:
-    Timer(bool doRandom, CallBackObj *toCall);
+    Timer(bool doRandom, CallBackObj *toCall, int cpuNum = 0);
 				// Initialize the timer, and callback to "toCall"
-				// every time slice.
+				// every time slice, on CPU "cpuNum".
     virtual ~Timer() {}
     
     void Disable() { disable = TRUE; }
@@ -39,6 +39,7 @@ class Timer : public CallBackObj {
   private:
     bool randomize;		// set if we need to use a random timeout delay
     CallBackObj *callPeriodically; // call this every TimerTicks time units 
+    int cpu;			// the CPU this timer interrupts
     bool disable;		// turn off the timer device after next
     				// interrupt.
     
@@ -6,8 +6,8 @@
 //
 // Two types of translation are supported here.
 //
-//	Linear page table -- the virtual page # is used as an index
-//	into the table, to find the physical page #.
+//	Page table -- the virtual page # is used to find the entry in
+//	the table (see pagetable.h), to find the physical page #.
 //
 //	Translation lookaside buffer -- associative lookup in the table
 //	to find an entry with the same virtual page #.  If found,
@@ -88,27 +88,33 @@ Machine::ReadMem(int addr, int size, int *value)
     int data;
     ExceptionType exception;
     int physicalAddress;
+    char *host = SoftTranslate(addr, size, SoftRead);
+
+    if (host == NULL) {		// not in the soft TLB, do it the slow way
+	DEBUG(dbgAddr, "Reading VA " << addr << ", size " << size);
     
-    DEBUG(dbgAddr, "Reading VA " << addr << ", size " << size);
-    
-    exception = Translate(addr, &physicalAddress, size, FALSE);
-    if (exception != NoException) {
-	RaiseException(exception, addr);
-	return FALSE;
+	exception = Translate(addr, &physicalAddress, size, FALSE);
+	if (exception != NoException) {
+	    RaiseException(exception, addr);
+	    return FALSE;
+	}
+	host = &mainMemory[physicalAddress];
     }
+    if (dcache != NULL)
+	CacheReference(dcache, host - mainMemory, FALSE);
     switch (size) {
       case 1:
-	data = mainMemory[physicalAddress];
+	data = *host;
 	*value = data;
 	break;
 	
       case 2:
-	data = *(unsigned short *) &mainMemory[physicalAddress];
+	data = *(unsigned short *) host;
 	*value = ShortToHost(data);
 	break;
 	
       case 4:
-	data = *(unsigned int *) &mainMemory[physicalAddress];
+	data = *(unsigned int *) host;
 	*value = WordToHost(data);
 	break;
 
@@ -137,27 +143,34 @@ Machine::WriteMem(int addr, int size, int value)
 {
     ExceptionType exception;
     int physicalAddress;
-     
-    DEBUG(dbgAddr, "Writing VA " << addr << ", size " << size << ", value " << value);
+    char *host = SoftTranslate(addr, size, SoftWrite);
+
+    if (host == NULL) {		// not in the soft TLB, do it the slow way
+	DEBUG(dbgAddr, "Writing VA " << addr << ", size " << size << ", value " << value);
 
-    exception = Translate(addr, &physicalAddress, size, TRUE);
-    if (exception != NoException) {
-	RaiseException(exception, addr);
-	return FALSE;
+	exception = Translate(addr, &physicalAddress, size, TRUE);
+	if (exception != NoException) {
+	    RaiseException(exception, addr);
+	    return FALSE;
+	}
+	host = &mainMemory[physicalAddress];
     }
+    if (decodedPage[(host - mainMemory) / PageSize])
+	InvalidateDecodedPage((host - mainMemory) / PageSize);  // self-modifying
+    if (dcache != NULL)
+	CacheReference(dcache, host - mainMemory, TRUE);
     switch (size) {
       case 1:
-	mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
+	*host = (unsigned char) (value & 0xff);
 	break;
 
       case 2:
-	*(unsigned short *) &mainMemory[physicalAddress]
+	*(unsigned short *) host
 		= ShortToMachine((unsigned short) (value & 0xffff));
 	break;
       
       case 4:
-	*(unsigned int *) &mainMemory[physicalAddress]
-		= WordToMachine((unsigned int) value);
+	*(unsigned int *) host = WordToMachine((unsigned int) value);
 	break;
 	
       default: ASSERT(FALSE);
@@ -205,27 +218,34 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     vpn = (unsigned) virtAddr / PageSize;
     offset = (unsigned) virtAddr % PageSize;
     
-    if (tlb == NULL) {		// => page table => vpn is index into table
+    if (tlb == NULL) {		// => page table => look vpn up in it
 	if (vpn >= pageTableSize) {
 	    DEBUG(dbgAddr, "Illegal virtual page # " << virtAddr);
 	    return AddressErrorException;
-	} else if (!pageTable[vpn].valid) {
+	} else if ((entry = pageTable->Walk(vpn)) == NULL || !entry->valid) {
 	    DEBUG(dbgAddr, "Invalid virtual page # " << virtAddr);
 	    return PageFaultException;
 	}
-	entry = &pageTable[vpn];
-    } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
+    } else {				// only look in vpn's set
+	int first = (vpn % (tlbSize / tlbWays)) * tlbWays;
+
+	tlbReferences++;
+        for (entry = NULL, i = first; i < first + tlbWays; i++)
     	    if (tlb[i].valid && (tlb[i].virtualPage == ((int)vpn))) {
 		entry = &tlb[i];			// FOUND!
 		break;
 	    }
 	if (entry == NULL) {				// not found
     	    DEBUG(dbgAddr, "Invalid TLB entry for this virtual page!");
+	    kernel->stats->numTLBMisses++;
     	    return PageFaultException;		// really, this is a TLB fault,
 						// the page may be in memory,
 						// but not in the TLB
 	}
+	kernel->stats->numTLBHits++;
+	if (tlbPolicy == TLBLRU)
+	    tlbStamp[i] = tlbReferences;
+	tlbReferenced[i] = TRUE;
     }
 
     if (entry->readOnly && writing) {	// trying to write to a read-only page
@@ -246,5 +266,62 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     *physAddr = pageFrame * PageSize + offset;
     ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
     DEBUG(dbgAddr, "phys addr = " << *physAddr);
+
+    // Remember the translation in the soft TLB, unless we are tracing
+    // addresses, or simulating a TLB: then every reference has to come
+    // through here.
+    if (tlb == NULL && !debug->IsEnabled(dbgAddr)) {
+	SoftTLBEntry *soft = &softTLB[vpn & (SoftTLBSize - 1)];
+
+	soft->vpn = vpn;
+	soft->page = &mainMemory[pageFrame * PageSize];
+	soft->perm = SoftRead;
+	if (entry->dirty && !entry->readOnly)
+	    soft->perm |= SoftWrite;
+    }
     return NoException;
 }
+
+//----------------------------------------------------------------------
+// Machine::SoftTranslate
+// 	Look a virtual address up in the soft TLB.  On a hit, return
+//	where its bytes are in mainMemory; on a miss, or if the entry does
+//	not allow the access, return NULL, and let the caller go through
+//	Translate (which will refill the entry if the access is legal).
+//
+//	A hit is exactly what Translate would have done: the access is
+//	aligned, and the translation entry already has the use bit (and
+//	the dirty bit, for a write) set, so there is nothing to update.
+//
+//	"virtAddr" -- the virtual address to translate
+//	"size" -- the amount of memory being read or written
+// 	"perm" -- SoftRead or SoftWrite
+//----------------------------------------------------------------------
+
+char *
+Machine::SoftTranslate(int virtAddr, int size, int perm)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    SoftTLBEntry *soft = &softTLB[vpn & (SoftTLBSize - 1)];
+
+    if (soft->vpn == (int) vpn && (soft->perm & perm)
+		&& (virtAddr & (size - 1)) == 0) {
+	kernel->stats->numSoftTLBHits++;
+	return soft->page + (unsigned) virtAddr % PageSize;
+    }
+    kernel->stats->numSoftTLBMisses++;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushSoftTLB
+// 	Empty the soft TLB, so that the next reference to every page goes
+//	through Translate again.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushSoftTLB()
+{
+    for (int i = 0; i < SoftTLBSize; i++)
+	softTLB[i].vpn = -1;
+}
@@ -0,0 +1,72 @@
+#!/bin/bash
+
+# Compare the user-program simulator engines (nachos -sim <engine>) by
+# simulated user instructions per host second.  Every user instruction
+# costs one UserTick, so the "user" ticks that Nachos prints when it
+# halts are the number of instructions simulated.
+#
+# Usage: ./simbench.sh [program ...]	(default: simbench)
+# memops exercises memory references rather than the ALU.
+# The programs must end with Halt(), so that the statistics get printed.
+
+ENGINES=(ref threaded)
+ROUNDS=3
+
+if [ $# -gt 0 ]; then
+    PROGS=("$@")
+else
+    PROGS=(simbench)
+fi
+
+# Check if script is in the right directory
+if [ ${PWD##*/} != "code" ]; then 
+    echo -e "\n@@@@@ Script should be put in ./code @@@@@\n"
+    exit 1
+fi
+
+# Build nachos
+echo -e "===== Make nachos ====="
+cd build.linux/
+make -j2 > /dev/null 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "Nachos built failed"
+    exit 1
+fi
+cd ..
+
+# Build test programs
+echo -e "===== Make test programs ====="
+cd test
+make ${PROGS[@]} > /dev/null 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "Tests built failed"
+    exit 1
+fi
+
+# Start benchmark; report the best of ROUNDS runs
+echo -e "===== Start benchmark ====="
+printf "%-12s %-10s %12s %10s %14s\n" program engine "user ticks" seconds "instr/second"
+for prog in ${PROGS[@]}; do
+    for engine in ${ENGINES[@]}; do
+	best=""
+	for ((r=0; r<$ROUNDS; r++)); do
+	    start=$(date +%s%N)
+	    out=$(../build.linux/nachos -sim $engine -e $prog)
+	    end=$(date +%s%N)
+	    ns=$(($end - $start))
+	    if [ -z "$best" ] || [ $ns -lt $best ]; then
+		best=$ns
+	    fi
+	done
+	user=$(echo "$out" | sed -n 's/^Ticks:.*user \([0-9]*\).*/\1/p')
+	if [ -z "$user" ]; then
+	    echo -e "$prog did not halt under -sim $engine"
+	    continue
+	fi
+	awk -v p=$prog -v e=$engine -v u=$user -v ns=$best 'BEGIN {
+	    printf "%-12s %-10s %12d %10.3f %14.0f\n", p, e, u, ns / 1e9, u / (ns / 1e9)
+	}'
+    done
+done
+
+exit 0
@@ -0,0 +1,33 @@
+/* bigmem.c
+ *	Test program for demand paging (nachos -vm <policy>): its array alone is
+ *	larger than the 128 frames of physical memory, so it can only
+ *	run if pages are written out to swap space and read back in.
+ *
+ *	Fills the array, then checks it twice, sweeping the other way
+ *	the second time; exits with 1 if any word comes back wrong, or
+ *	else halts, so that Nachos prints its paging statistics.
+ */
+
+#include "syscall.h"
+
+#define SIZE	6144		/* words; 192 pages of 128 bytes */
+
+int A[SIZE];
+
+int
+main()
+{
+    int i;
+
+    for (i = 0; i < SIZE; i++)
+	A[i] = i * 7 + 3;
+    for (i = 0; i < SIZE; i++)
+	if (A[i] != i * 7 + 3)
+	    Exit(1);
+    for (i = SIZE - 1; i >= 0; i--)
+	if (A[i] != i * 7 + 3)
+	    Exit(1);
+    Halt();
+    /* not reached */
+    return 0;
+}
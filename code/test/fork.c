@@ -0,0 +1,78 @@
+/* fork.c
+ *	Test program for Fork, Exec, Join and Exit.  Run with "-e fork";
+ *	Fork is not there with demand paging (-vm).
+ *
+ *	A child forked from us starts with a copy of our memory, and its
+ *	changes must not show up in ours, nor ours in its.  Prints, in
+ *	order:
+ *
+ *	7	the status of the first child
+ *	-1	joining it a second time
+ *	1	the status of hw3t1, started with Exec
+ *	1800	the sum of the statuses of five more children
+ *
+ *	and exits with 0; or with 99 if any copy sees a wrong value.
+ */
+
+#include "syscall.h"
+
+#define SIZE	16
+#define NCHILD	5
+
+int A[SIZE];
+SpaceId Pid[NCHILD + 1];
+
+int
+main()
+{
+    int i, k, sum;
+    SpaceId id;
+
+    for (i = 0; i < SIZE; i++)
+	A[i] = i;
+
+    id = Fork();
+    if (id == 0) {
+	for (i = 0; i < SIZE; i++) {
+	    if (A[i] != i)
+		Exit(99);
+	    A[i] = i + 100;
+	}
+	Exit(7);
+    }
+    if (id < 0)
+	Exit(99);
+    PrintInt(Join(id));
+    for (i = 0; i < SIZE; i++)
+	if (A[i] != i)
+	    Exit(99);
+    PrintInt(Join(id));
+
+    PrintInt(Join(Exec("hw3t1")));
+
+    /* each child sees what we wrote before forking it, and exits
+       with the sum of what it then writes: 120 * k */
+    for (k = 1; k <= NCHILD; k++) {
+	id = Fork();
+	if (id == 0) {
+	    sum = 0;
+	    for (i = 0; i < SIZE; i++) {
+		if (A[i] != i + 1000 * (k - 1))
+		    Exit(99);
+		A[i] = i * k;
+		sum += A[i];
+	    }
+	    Exit(sum);
+	}
+	if (id < 0)
+	    Exit(99);
+	Pid[k] = id;
+	for (i = 0; i < SIZE; i++)
+	    A[i] = i + 1000 * k;
+    }
+    sum = 0;
+    for (k = 1; k <= NCHILD; k++)
+	sum += Join(Pid[k]);
+    PrintInt(sum);
+    Exit(0);
+}
@@ -0,0 +1,44 @@
+/* heap.c
+ *	Test program for Sbrk and malloc (see malloc.h): its arrays are
+ *	sized to what each round asks for, not to the most any could.
+ *
+ *	For n = 10, 100 and 1000, allocates an array of n words and then
+ *	one of n bytes, fills them, prints the sum of the words, and
+ *	frees both; the free list has to split and merge blocks, and
+ *	grow the heap more than once.  Then prints 1 if all the heap went
+ *	back to the kernel, and exits with 0; or exits with 1 if malloc
+ *	fails.  Prints 45, 4950, 499500 and 1.
+ */
+
+#include "syscall.h"
+#include "malloc.h"
+
+int
+main()
+{
+    int start = Sbrk(0);
+    int n, i, sum, *a;
+    char *b;
+
+    for (n = 10; n <= 1000; n *= 10) {
+	a = (int *) malloc(n * sizeof(int));
+	b = (char *) malloc(n);
+	if (a == 0 || b == 0)
+	    Exit(1);
+	for (i = 0; i < n; i++) {
+	    a[i] = i;
+	    b[i] = (char) i;
+	}
+	sum = 0;
+	for (i = 0; i < n; i++) {
+	    if (b[i] != (char) a[i])
+		Exit(1);
+	    sum += a[i];
+	}
+	PrintInt(sum);
+	free(a);
+	free(b);
+    }
+    PrintInt(Sbrk(0) == start);
+    Exit(0);
+}
@@ -0,0 +1,35 @@
+/* loopset.c
+ *	Memory access pattern for comparing page replacement policies
+ *	(see ../vmbench.sh): a loop over a working set somewhat larger
+ *	than physical memory, plus a small hot set that is used all the
+ *	time and should never be paged out.
+ *
+ *	Each round updates one word per page of the working set, and
+ *	reads the hot set in between.  Halts when done.
+ */
+
+#include "syscall.h"
+
+#define PAGE	32		/* words per page of 128 bytes */
+#define LOOP	160		/* pages in the loop */
+#define HOT	8		/* pages in the hot set */
+#define ROUNDS	10
+
+int Loop[LOOP * PAGE];
+int Hot[HOT * PAGE];
+
+int
+main()
+{
+    int r, i, sum = 0;
+
+    for (r = 0; r < ROUNDS; r++) {
+	for (i = 0; i < LOOP; i++) {
+	    Loop[i * PAGE + r] += i;
+	    sum += Hot[(i % HOT) * PAGE];
+	}
+    }
+    Halt();
+    /* not reached */
+    return sum;
+}
@@ -0,0 +1,128 @@
+/* malloc.c
+ *	A simple memory allocator for user programs, on top of Sbrk.
+ *
+ *	The free blocks are kept on a list, in address order.  A request
+ *	takes the first block that is big enough, splitting off what it
+ *	does not need; if there is none, the heap grows by enough whole
+ *	pages.  A block that is freed is merged with the free blocks on
+ *	either side of it, and whole pages of a free block at the end of
+ *	the heap go back to the kernel, which gives up their frames.
+ */
+
+#include "syscall.h"
+#include "malloc.h"
+
+#define PAGE	128		/* bytes; the heap grows a page at a time */
+
+typedef struct Header {
+    unsigned int size;		/* bytes in the block, header included */
+    struct Header *next;	/* the next free block, by address */
+} Header;			/* 8 bytes, so blocks stay 8-byte aligned */
+
+static Header *freeList = 0;
+static char *heapEnd = 0;	/* where the heap ends; always on a page
+				   boundary */
+
+/* Put "block" on the free list, merged with the free blocks next to
+ * it; return the link on the list that points to the merged block.
+ */
+static Header **
+Insert(Header *block)
+{
+    Header *before = 0, *after, **prev, **beforeLink = 0;
+
+    for (prev = &freeList; (after = *prev) != 0 && after < block;
+	 prev = &after->next) {
+	before = after;
+	beforeLink = prev;
+    }
+    block->next = after;
+    *prev = block;
+    if (after != 0 && (char *) block + block->size == (char *) after) {
+	block->size += after->size;
+	block->next = after->next;
+    }
+    if (before != 0 && (char *) before + before->size == (char *) block) {
+	before->size += block->size;
+	before->next = block->next;
+	prev = beforeLink;
+    }
+    return prev;
+}
+
+/* Grow the heap by enough pages for a block of "size" bytes, and put
+ * them on the free list.  Return 0 if the heap cannot grow.
+ */
+static int
+Grow(unsigned int size)
+{
+    Header *block;
+    int end;
+
+    size = (size + PAGE - 1) / PAGE * PAGE;
+    end = Sbrk(size);
+    if (end == -1)
+	return 0;
+    block = (Header *) end;
+    block->size = size;
+    heapEnd = (char *) end + size;
+    Insert(block);
+    return 1;
+}
+
+void *
+malloc(unsigned int size)
+{
+    Header *block, *rest, **prev;
+
+    if (size == 0)
+	return 0;
+    size = (size + sizeof(Header) + 7) / 8 * 8;
+    for (;;) {
+	for (prev = &freeList; (block = *prev) != 0; prev = &block->next) {
+	    if (block->size < size)
+		continue;
+	    if (block->size - size >= 2 * sizeof(Header)) {
+		rest = (Header *) ((char *) block + size);
+		rest->size = block->size - size;
+		rest->next = block->next;
+		*prev = rest;
+		block->size = size;
+	    } else {
+		*prev = block->next;
+	    }
+	    return (void *) (block + 1);
+	}
+	if (!Grow(size))
+	    return 0;
+    }
+}
+
+void
+free(void *ptr)
+{
+    Header *block, **link;
+    unsigned int tail;
+
+    if (ptr == 0)
+	return;
+    link = Insert((Header *) ptr - 1);
+    block = *link;
+
+    /* give back the whole pages of a free block at the end of the
+       heap, so that the kernel can give their frames to others */
+    if ((char *) block + block->size != heapEnd)
+	return;
+    tail = block->size / PAGE * PAGE;
+    if (tail > 0 && tail < block->size
+	  && block->size - tail < 2 * sizeof(Header))
+	tail -= PAGE;			/* what is left must hold a block */
+    if (tail == 0)
+	return;
+    if (tail == block->size)
+	*link = 0;			/* it is the last one on the list */
+    else
+	block->size -= tail;
+    heapEnd -= tail;
+    Sbrk(-(int) tail);
+}
@@ -0,0 +1,20 @@
+/* malloc.h
+ *	Dynamic memory for user programs: blocks carved out of the heap,
+ *	which grows (and shrinks back) with the Sbrk system call.  Link
+ *	malloc.o in with the program to use them.
+ */
+
+#ifndef MALLOC_H
+#define MALLOC_H
+
+/* Return a block of at least "size" bytes, aligned for any type, or
+ * 0 if the heap cannot grow enough.  Its contents are undefined.
+ */
+void *malloc(unsigned int size);
+
+/* Give back a block that malloc returned (or do nothing, if "ptr" is
+ * 0).
+ */
+void free(void *ptr);
+
+#endif /* MALLOC_H */
@@ -0,0 +1,56 @@
+/* mapsort.c
+ *	Test program for Map and Unmap: sorts an array of integers kept in
+ *	a file, "mapsort.data", working on the file where it is mapped
+ *	into memory instead of reading it into a buffer.
+ *
+ *	Writes the file in reverse sorted order, maps it, sorts it in
+ *	place, and unmaps it, which writes the sorted pages back.  Then
+ *	maps it again, checks that it is sorted, and prints the first and
+ *	last of the integers, 0 and 255.  Exits with 0; or with 1 if a
+ *	system call fails, or 2 if the file did not come back sorted.
+ */
+
+#include "syscall.h"
+
+#define SIZE	256
+
+int
+main()
+{
+    OpenFileId id;
+    int i, j, tmp, *A;
+
+    if (Create("mapsort.data") != 1 || (id = Open("mapsort.data")) < 0)
+	Exit(1);
+    for (i = 0; i < SIZE; i++) {
+	tmp = (SIZE - 1) - i;
+	Write((char *) &tmp, sizeof(int), id);
+    }
+    if ((A = (int *) Map(id, SIZE * sizeof(int))) == (int *) -1)
+	Exit(1);
+    Close(id);			/* the mapping keeps it open */
+
+    for (i = 0; i < SIZE; i++) {
+	for (j = 0; j < SIZE - 1 - i; j++) {
+	    if (A[j] > A[j + 1]) {
+		tmp = A[j];
+		A[j] = A[j + 1];
+		A[j + 1] = tmp;
+	    }
+	}
+    }
+    if (Unmap((int) A) != 0)
+	Exit(1);
+
+    if ((id = Open("mapsort.data")) < 0
+	  || (A = (int *) Map(id, SIZE * sizeof(int))) == (int *) -1)
+	Exit(1);
+    Close(id);
+    for (i = 0; i < SIZE; i++) {
+	if (A[i] != i)
+	    Exit(2);
+    }
+    PrintInt(A[0]);
+    PrintInt(A[SIZE - 1]);
+    Exit(0);
+}
@@ -0,0 +1,42 @@
+/* matblock.c 
+ *    Matrix multiplication, like matmult.c, but done block by block,
+ *    so that each block of the matrices is reused while it is still
+ *    in the cache.
+ *
+ *    Run it, and matmult, with -dcache to compare the stalls; it ends
+ *    with Halt so that Nachos prints its statistics.
+ */
+
+#include "syscall.h"
+
+#define Dim 	20	/* same arrays as matmult.c */
+#define Block	4	/* must divide Dim */
+
+int A[Dim][Dim];
+int B[Dim][Dim];
+int C[Dim][Dim];
+
+int
+main()
+{
+    int i, j, k, ii, jj, kk;
+
+    for (i = 0; i < Dim; i++)		/* first initialize the matrices */
+	for (j = 0; j < Dim; j++) {
+	     A[i][j] = i;
+	     B[i][j] = j;
+	     C[i][j] = 0;
+	}
+
+    for (ii = 0; ii < Dim; ii += Block)	/* then multiply them, a */
+	for (kk = 0; kk < Dim; kk += Block)	/* block at a time */
+	    for (jj = 0; jj < Dim; jj += Block)
+		for (i = ii; i < ii + Block; i++)
+		    for (k = kk; k < kk + Block; k++)
+			for (j = jj; j < jj + Block; j++)
+			    C[i][j] += A[i][k] * B[k][j];
+
+    PrintInt(C[Dim-1][Dim-1]);
+    Halt();
+    /* not reached */
+}
@@ -0,0 +1,44 @@
+/* memops.c
+ *	Load/store-bound test program, for measuring how the simulator
+ *	handles memory references (see ../simbench.sh, and the "Soft TLB"
+ *	line that Nachos prints when it halts, with -stlb).
+ *
+ *	Copies, sums and strides over an array spanning many pages, with
+ *	word, halfword and byte references, and then halts.
+ */
+
+#include "syscall.h"
+
+#define SIZE	512		/* words; 16 pages of 128 bytes */
+#define STRIDE	37		/* words; touches a new page almost every time */
+#define ROUNDS	8
+
+int A[SIZE];
+int B[SIZE];
+short H[SIZE];
+char C[SIZE];
+
+int
+main()
+{
+    int r, i, j, sum = 0;
+
+    for (r = 0; r < ROUNDS; r++) {
+	for (i = 0; i < SIZE; i++)		/* sequential stores */
+	    A[i] = i + r;
+	for (i = 0; i < SIZE; i++)		/* copy */
+	    B[i] = A[i];
+	for (i = 0, j = 0; i < SIZE; i++) {	/* strided loads */
+	    sum += B[j];
+	    j = (j + STRIDE) % SIZE;
+	}
+	for (i = 0; i < SIZE; i++) {		/* halfwords and bytes */
+	    H[i] = (short) A[i];
+	    C[i] = (char) H[i];
+	    sum += C[i];
+	}
+    }
+    Halt();
+    /* not reached */
+    return sum;
+}
@@ -0,0 +1,34 @@
+/* randpages.c
+ *	Memory access pattern for comparing page replacement policies
+ *	(see ../vmbench.sh): references spread at random over an array
+ *	larger than physical memory, one in four of them a store.
+ *
+ *	The pseudo-random sequence is fixed, so every run makes the same
+ *	references.  Halts when done.
+ */
+
+#include "syscall.h"
+
+#define SIZE	8192		/* words; 256 pages of 128 bytes */
+#define REFS	20000
+
+int A[SIZE];
+
+int
+main()
+{
+    unsigned int seed = 12345;
+    int r, i, sum = 0;
+
+    for (r = 0; r < REFS; r++) {
+	seed = seed * 1103515245 + 12345;	/* the C library's LCG */
+	i = (seed >> 8) % SIZE;
+	if ((seed >> 4) % 4 == 0)
+	    A[i] = r;
+	else
+	    sum += A[i];
+    }
+    Halt();
+    /* not reached */
+    return sum;
+}
@@ -0,0 +1,30 @@
+/* seqscan.c
+ *	Memory access pattern for comparing page replacement policies
+ *	(see ../vmbench.sh): sequential scans over an array larger than
+ *	physical memory, the worst case for FIFO and LRU alike.
+ *
+ *	Writes the whole array once, then reads it through PASSES more
+ *	times, and halts.
+ */
+
+#include "syscall.h"
+
+#define SIZE	8192		/* words; 256 pages of 128 bytes */
+#define PASSES	4
+
+int A[SIZE];
+
+int
+main()
+{
+    int p, i, sum = 0;
+
+    for (i = 0; i < SIZE; i++)
+	A[i] = i;
+    for (p = 0; p < PASSES; p++)
+	for (i = 0; i < SIZE; i++)
+	    sum += A[i];
+    Halt();
+    /* not reached */
+    return sum;
+}
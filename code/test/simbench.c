@@ -0,0 +1,52 @@
+/* simbench.c
+ *	CPU-bound test program, for comparing the simulator engines
+ *	(see ../simbench.sh).
+ *
+ *	Sorts and multiplies small arrays a few times over, mostly in
+ *	tight loops, and then halts, so that Nachos prints how many user
+ *	instructions it simulated.
+ */
+
+#include "syscall.h"
+
+#define SIZE	256
+#define Dim	16
+#define ROUNDS	4
+
+int A[SIZE];
+int X[Dim][Dim];
+int Y[Dim][Dim];
+int Z[Dim][Dim];
+
+int
+main()
+{
+    int r, i, j, k, tmp;
+
+    for (r = 0; r < ROUNDS; r++) {
+	for (i = 0; i < SIZE; i++)		/* reverse order */
+	    A[i] = (SIZE - 1) - i;
+	for (i = 0; i < SIZE; i++)		/* bubble sort */
+	    for (j = 0; j < (SIZE - 1); j++)
+		if (A[j] > A[j + 1]) {
+		    tmp = A[j];
+		    A[j] = A[j + 1];
+		    A[j + 1] = tmp;
+		}
+
+	for (i = 0; i < Dim; i++)
+	    for (j = 0; j < Dim; j++) {
+		X[i][j] = i;
+		Y[i][j] = j;
+		Z[i][j] = 0;
+	    }
+	for (i = 0; i < Dim; i++)
+	    for (j = 0; j < Dim; j++)
+		for (k = 0; k < Dim; k++)
+		    Z[i][j] += X[i][k] * Y[k][j];
+    }
+
+    PrintInt(A[SIZE - 1] + Z[Dim - 1][Dim - 1]);
+    Halt();
+    /* not reached */
+}
@@ -0,0 +1,38 @@
+/* stack.c
+ *	Test program for a user stack that grows as it is touched.
+ *
+ *	Each call of Sum has a frame of over 256 bytes, so recursing 20
+ *	deep takes more than the 1024 bytes of stack a program starts
+ *	with, but less than the 8192 it may grow to by default.  Prints
+ *	210, the sum of 1 to 20, and exits with 0; or exits with 99 if a
+ *	frame does not keep what was written to it.
+ *
+ *	Run with "-stack 4096" to see it overflow into the guard page
+ *	instead.
+ */
+
+#include "syscall.h"
+
+#define WORDS	64
+
+int
+Sum(int n)
+{
+    int frame[WORDS];
+    int i, sum;
+
+    for (i = 0; i < WORDS; i++)
+	frame[i] = n + i;
+    sum = (n > 1) ? Sum(n - 1) : 0;
+    for (i = 0; i < WORDS; i++)
+	if (frame[i] != n + i)
+	    Exit(99);
+    return sum + n;
+}
+
+int
+main()
+{
+    PrintInt(Sum(20));
+    Exit(0);
+}
@@ -11,6 +11,7 @@
 #include "copyright.h"
 #include "alarm.h"
 #include "main.h"
+#include "replacement.h"
 
 //----------------------------------------------------------------------
 // Alarm::Alarm
@@ -18,11 +19,12 @@
 //
 //      "doRandom" -- if true, arrange for the hardware interrupts to 
 //		occur at random, instead of fixed, intervals.
+//      "cpu" -- the CPU whose threads to time-slice
 //----------------------------------------------------------------------
 
-Alarm::Alarm(bool doRandom)
+Alarm::Alarm(bool doRandom, int cpu)
 {
-    timer = new Timer(doRandom, this);
+    timer = new Timer(doRandom, this, cpu);
 }
 
 //----------------------------------------------------------------------
@@ -49,6 +51,9 @@ Alarm::Alarm(bool doRandom)
 //  3. current thread is L1, but L1 ready list's front has lower remaining burst
 //  To preempt, call YieldOnReturn()
 //  [END-of-ADD]
+//
+//  On a multiprocessor, each CPU has its own alarm, which only looks
+//  at that CPU's threads; an idle CPU has nothing to update or preempt.
 //----------------------------------------------------------------------
 
 void 
@@ -57,8 +62,14 @@ Alarm::CallBack()
     Interrupt *interrupt = kernel->interrupt;
     MachineStatus status = interrupt->getStatus();
     
+    if (kernel->replacement != NULL)	// age the pages' use bits
+	kernel->replacement->Sample();
+
     // [ADD MP3]
     Thread *currentThread = kernel->currentThread;
+    if (currentThread == kernel->cpu[kernel->currentCpu]->idleThread) {
+        return;
+    }
 
     // Update running ticks or waiting ticks
     // And since we calculate running ticks by setting start running tick
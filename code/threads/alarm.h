@@ -25,8 +25,10 @@
 // The following class defines a software alarm clock. 
 class Alarm : public CallBackObj {
   public:
-    Alarm(bool doRandomYield);	// Initialize the timer, and callback 
-				// to "toCall" every time slice.
+    Alarm(bool doRandomYield, int cpu = 0);
+				// Initialize the timer, and callback 
+				// to "toCall" every time slice, on
+				// CPU "cpu".
     ~Alarm() { delete timer; }
     
     void WaitUntil(int x);	// suspend execution until time > now + x
@@ -0,0 +1,89 @@
+// cpu.cc 
+//	Routines to manage the simulated CPUs of a multiprocessor.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "cpu.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// IdleLoop
+// 	The procedure run by each CPU's idle thread.  Whenever one of the
+//	CPU's threads goes to sleep with nothing else ready, the CPU runs
+//	this, instead of idling inside Thread::Sleep, so that it can let
+//	the other CPUs run while it waits.
+//
+//	Before waiting, we try to take a thread from another CPU (see
+//	Scheduler::FindNextToRun).  Otherwise, we skip ahead to our
+//	next interrupt, which at worst is our next timer tick, and let
+//	the CPUs that are now behind us catch up.
+//
+//	"arg" is the CPU, cast to a void *
+//----------------------------------------------------------------------
+
+static void
+IdleLoop(void *arg)
+{
+    Cpu *cpu = (Cpu *) arg;
+    Interrupt *interrupt = kernel->interrupt;
+    Scheduler *scheduler = kernel->scheduler;
+    Thread *nextThread;
+    int start;
+
+    (void) interrupt->SetLevel(IntOff);
+    for (;;) {
+	ASSERT(kernel->currentThread == cpu->idleThread);
+	nextThread = scheduler->FindNextToRun();
+	if (nextThread != NULL) {
+	    cpu->idleThread->setStatus(BLOCKED);
+	    scheduler->Run(nextThread, FALSE);	// back when it sleeps
+	} else {
+	    start = kernel->stats->totalTicks;
+	    interrupt->Idle();
+	    cpu->idleTicks += kernel->stats->totalTicks - start;
+	    scheduler->SwitchCpu();
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// Cpu::Cpu
+// 	Initialize the kernel's state for one of the CPUs.  On a
+//	multiprocessor, that includes its idle thread, which is where the
+//	CPU starts out, unless it is the one running the "main" thread.
+//
+//	"cpuId" is the number of the CPU
+//	"cpuAlarm" is the time-slicing timer that interrupts it
+//----------------------------------------------------------------------
+
+Cpu::Cpu(int cpuId, Alarm *cpuAlarm)
+{
+    id = cpuId;
+    alarm = cpuAlarm;
+    tlb = NULL;
+    clock = 0;
+    idleTicks = 0;
+    steals = 0;
+    idleThread = NULL;
+    if (kernel->numCpus > 1) {
+	idleThread = new Thread("idle", -1, 0);
+	idleThread->setCpu(id);
+	idleThread->Prepare(IdleLoop, (void *) this);
+    }
+    currentThread = idleThread;
+}
+
+//----------------------------------------------------------------------
+// Cpu::Print
+// 	Print the CPU's statistics.
+//----------------------------------------------------------------------
+
+void
+Cpu::Print()
+{
+    cout << "CPU " << id << ": clock " << clock << ", idle " << idleTicks
+	 << ", steals " << steals << "\n";
+}
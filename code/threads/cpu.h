@@ -0,0 +1,57 @@
+// cpu.h 
+//	Data structures for simulating a shared-memory multiprocessor.
+//
+//	With "-smp N", the kernel runs N simulated CPUs.  They share
+//	the Machine -- its physical memory, and its registers, which each
+//	CPU saves and restores as if they were its own -- but each CPU
+//	has its own current thread, timer, ready queues and clock.
+//
+//	The CPUs take turns on a single host thread: whenever a CPU gets
+//	more than CpuSkew ticks ahead of the one furthest behind, it
+//	stops after its current user instruction, and that CPU runs
+//	instead (see Scheduler::SwitchCpu).  So runs stay repeatable, and
+//	only one CPU is ever inside the kernel at a time.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CPU_H
+#define CPU_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Thread;
+class Alarm;
+class TranslationEntry;
+
+const int MaxCpus = 8;		// most CPUs we can simulate
+const int CpuSkew = 10;		// ticks a CPU may run ahead of the others
+
+// The following class defines the per-CPU state of the kernel.
+// Most of it is only looked at while the CPU is not the one being
+// simulated; meanwhile, the live copies are kernel->currentThread and
+// kernel->stats->totalTicks.  So totalTicks goes back when we switch
+// to a CPU that is behind; the scheduler times threads by
+// kernel->stats->GlobalTicks() instead, which does not.
+
+class Cpu {
+  public:
+    Cpu(int cpuId, Alarm *cpuAlarm);	// initialize CPU "cpuId"
+    ~Cpu() {}
+
+    void Print();		// print this CPU's statistics
+
+    int id;			// which CPU this is
+    Thread *currentThread;	// the thread it is running
+    Thread *idleThread;		// what it runs when it has nothing
+				// to do; NULL on a uniprocessor
+    Alarm *alarm;		// its time-slicing timer
+    TranslationEntry *tlb;	// its TLB, if the Machine has one
+    int clock;			// its simulated time
+    int idleTicks;		// time it spent idle
+    int steals;			// # of threads it took from other CPUs
+};
+
+#endif // CPU_H
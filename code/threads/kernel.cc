@@ -17,6 +17,14 @@
 #include "synchdisk.h"
 #include "post.h"
 #include "synchconsole.h"
+#include "cache.h"
+#include "trace.h"
+#include "eventlog.h"
+#include "swap.h"
+#include "replacement.h"
+#include "frames.h"
+#include "textcache.h"
+#include "process.h"
 
 //----------------------------------------------------------------------
 // Kernel::Kernel
@@ -28,8 +36,30 @@ Kernel::Kernel(int argc, char **argv)
 {
     randomSlice = FALSE; 
     debugUserProg = FALSE;
+    numCpus = 1;		// default is a uniprocessor
+    currentCpu = 0;
+    simEngine = ReferenceEngine;
+    tlbSize = 0;		// default is a linear page table
+    tlbWays = 0;
+    tlbPolicy = TLBFIFO;
+    icache = dcache = NULL;	// default is no caches
+    profiling = FALSE;
+    softTLBStats = FALSE;
+    demandPaging = FALSE;	// default is to load programs whole
+    clusterPages = 1;		// default is one page per page fault
+    zeroFill = FALSE;		// default is to zero every page at load
+    contiguousFrames = FALSE;	// default is the lowest free frames
+    stackLimit = UserStackLimit;
+    pageTableKind = LinearTable;
+    zeroFrame = -1;
+    swapSpace = NULL;
+    replacement = NULL;
+    pagingLock = NULL;
+    eventLog = NULL;		// default is to take inputs from the host
     consoleIn = NULL;          // default is stdin
     consoleOut = NULL;         // default is stdout
+    checkpointFile = NULL;	// default is no checkpoint
+    restoreFile = NULL;
 #ifndef FILESYS_STUB
     formatFlag = FALSE;
 #endif
@@ -45,6 +75,116 @@ Kernel::Kernel(int argc, char **argv)
 	    	i++;
         } else if (strcmp(argv[i], "-s") == 0) {
             debugUserProg = TRUE;
+        } else if (strcmp(argv[i], "-sim") == 0) {
+	    	ASSERT(i + 1 < argc);
+	    	if (strcmp(argv[i + 1], "threaded") == 0) {
+		    simEngine = ThreadedEngine;
+	    	} else if (strcmp(argv[i + 1], "jit") == 0) {
+		    simEngine = JitEngine;
+	    	} else if (strcmp(argv[i + 1], "diff") == 0) {
+		    simEngine = DiffEngine;
+	    	} else if (strcmp(argv[i + 1], "batch") == 0) {
+		    simEngine = BatchEngine;
+	    	} else {
+		    ASSERT(strcmp(argv[i + 1], "ref") == 0);
+		    simEngine = ReferenceEngine;
+	    	}
+	    	i++;
+        } else if (strcmp(argv[i], "-smp") == 0) {
+	    	ASSERT(i + 1 < argc);
+	    	numCpus = atoi(argv[i + 1]);
+	    	ASSERT(numCpus >= 1 && numCpus <= MaxCpus);
+	    	i++;
+        } else if (strcmp(argv[i], "-tlb") == 0) {
+	    	ASSERT(i + 3 < argc);	// size, ways, policy
+	    	tlbSize = atoi(argv[i + 1]);
+	    	tlbWays = atoi(argv[i + 2]);
+	    	if (strcmp(argv[i + 3], "random") == 0) {
+		    tlbPolicy = TLBRandom;
+	    	} else if (strcmp(argv[i + 3], "lru") == 0) {
+		    tlbPolicy = TLBLRU;
+	    	} else if (strcmp(argv[i + 3], "clock") == 0) {
+		    tlbPolicy = TLBClock;
+	    	} else {
+		    ASSERT(strcmp(argv[i + 3], "fifo") == 0);
+		    tlbPolicy = TLBFIFO;
+	    	}
+	    	i += 3;
+        } else if (strcmp(argv[i], "-icache") == 0) {
+	    	ASSERT(i + 3 < argc);	// line size, sets, ways
+	    	icache = new Cache(atoi(argv[i + 1]), atoi(argv[i + 2]),
+				   atoi(argv[i + 3]), WriteBack);
+	    	i += 3;
+        } else if (strcmp(argv[i], "-dcache") == 0) {
+	    	ASSERT(i + 4 < argc);	// line size, sets, ways, policy
+	    	ASSERT(strcmp(argv[i + 4], "wb") == 0
+		       || strcmp(argv[i + 4], "wt") == 0);
+	    	dcache = new Cache(atoi(argv[i + 1]), atoi(argv[i + 2]),
+				   atoi(argv[i + 3]),
+				   strcmp(argv[i + 4], "wt") == 0 ?
+					WriteThrough : WriteBack);
+	    	i += 4;
+        } else if (strcmp(argv[i], "-prof") == 0) {
+	    	profiling = TRUE;
+        } else if (strcmp(argv[i], "-stlb") == 0) {
+	    	softTLBStats = TRUE;
+        } else if (strcmp(argv[i], "-vm") == 0) {
+	    	ASSERT(i + 1 < argc);	// replacement policy
+	    	demandPaging = TRUE;
+	    	if (strcmp(argv[i + 1], "clock") == 0) {
+		    replacement = new Replacement(ReplaceClock);
+	    	} else if (strcmp(argv[i + 1], "eclock") == 0) {
+		    replacement = new Replacement(ReplaceEnhancedClock);
+	    	} else if (strcmp(argv[i + 1], "aging") == 0) {
+		    replacement = new Replacement(ReplaceAging);
+	    	} else if (strcmp(argv[i + 1], "wsclock") == 0) {
+		    replacement = new Replacement(ReplaceWSClock);
+	    	} else {
+		    ASSERT(strcmp(argv[i + 1], "fifo") == 0);
+		    replacement = new Replacement(ReplaceFIFO);
+	    	}
+	    	i++;
+        } else if (strcmp(argv[i], "-cluster") == 0) {
+	    	ASSERT(i + 1 < argc);	// pages
+	    	clusterPages = atoi(argv[i + 1]);
+	    	ASSERT(clusterPages >= 1 && clusterPages <= MaxClusterPages);
+	    	i++;
+        } else if (strcmp(argv[i], "-zf") == 0) {
+	    	zeroFill = TRUE;
+        } else if (strcmp(argv[i], "-contig") == 0) {
+	    	contiguousFrames = TRUE;
+        } else if (strcmp(argv[i], "-stack") == 0) {
+	    	ASSERT(i + 1 < argc);	// bytes
+	    	stackLimit = atoi(argv[i + 1]);
+	    	i++;
+        } else if (strcmp(argv[i], "-pt") == 0) {
+	    	ASSERT(i + 1 < argc);	// page table kind
+	    	if (strcmp(argv[i + 1], "2level") == 0) {
+		    pageTableKind = TwoLevelTable;
+	    	} else if (strcmp(argv[i + 1], "hashed") == 0) {
+		    pageTableKind = HashedTable;
+	    	} else {
+		    ASSERT(strcmp(argv[i + 1], "linear") == 0);
+		    pageTableKind = LinearTable;
+	    	}
+	    	i++;
+        } else if (strcmp(argv[i], "-ckpt") == 0) {
+	    	ASSERT(i + 2 < argc);	// tick, file
+	    	checkpointTick = atoi(argv[i + 1]);
+	    	checkpointFile = argv[i + 2];
+	    	i += 2;
+        } else if (strcmp(argv[i], "-restore") == 0) {
+	    	ASSERT(i + 1 < argc);
+	    	restoreFile = argv[i + 1];
+	    	i++;
+        } else if (strcmp(argv[i], "-record") == 0) {
+	    	ASSERT(i + 1 < argc);
+	    	eventLog = new EventLog(argv[i + 1], FALSE);
+	    	i++;
+        } else if (strcmp(argv[i], "-replay") == 0) {
+	    	ASSERT(i + 1 < argc);
+	    	eventLog = new EventLog(argv[i + 1], TRUE);
+	    	i++;
 		} else if (strcmp(argv[i], "-e") == 0) {
         	execfile[++execfileNum]= argv[++i];
 			cout << execfile[execfileNum] << "\n";
@@ -78,6 +218,17 @@ Kernel::Kernel(int argc, char **argv)
         } else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-rs randomSeed]\n";
 	   		cout << "Partial usage: nachos [-s]\n";
+	   		cout << "Partial usage: nachos [-sim ref|threaded|jit|diff|batch]\n";
+	   		cout << "Partial usage: nachos [-smp numCpus]\n";
+	   		cout << "Partial usage: nachos [-tlb size ways random|fifo|lru|clock]\n";
+	   		cout << "Partial usage: nachos [-icache lineSize sets ways]\n";
+	   		cout << "Partial usage: nachos [-dcache lineSize sets ways wb|wt]\n";
+	   		cout << "Partial usage: nachos [-prof] [-stlb]\n";
+	   		cout << "Partial usage: nachos [-vm fifo|clock|eclock|aging|wsclock]\n";
+	   		cout << "Partial usage: nachos [-zf] [-contig] [-stack bytes]\n";
+	   		cout << "Partial usage: nachos [-pt linear|2level|hashed]\n";
+	   		cout << "Partial usage: nachos [-ckpt tick file] [-restore file]\n";
+	   		cout << "Partial usage: nachos [-record file] [-replay file]\n";
             cout << "Partial usage: nachos [-ci consoleIn] [-co consoleOut]\n";
 #ifndef FILESYS_STUB
 	    	cout << "Partial usage: nachos [-nf]\n";
@@ -85,6 +236,13 @@ Kernel::Kernel(int argc, char **argv)
             cout << "Partial usage: nachos [-n #] [-m #]\n";
 		}
     }
+    // the other CPUs would need their own frames to fault into, and a
+    // checkpoint does not save the page tables' frames in swap space
+    if (demandPaging && (numCpus > 1 || checkpointFile != NULL
+			 || restoreFile != NULL)) {
+	cerr << "-vm cannot be used with -smp, -ckpt or -restore\n";
+	Abort();
+    }
 }
 
 //----------------------------------------------------------------------
@@ -108,17 +266,43 @@ Kernel::Initialize()
     stats = new Statistics();		// collect statistics
     interrupt = new Interrupt;		// start up interrupt handling
     scheduler = new Scheduler();	// initialize the ready queue
+    heldThreads = new List<Thread *>;
     alarm = new Alarm(randomSlice);	// start up time slicing
-    machine = new Machine(debugUserProg);
+    for (int i = 0; i < numCpus; i++)	// each CPU slices its own time
+	cpu[i] = new Cpu(i, (i == 0) ? alarm : new Alarm(randomSlice, i));
+    cpu[0]->currentThread = currentThread;
+    // the CPUs can only take turns between instructions that are
+    // simulated one by one
+    machine = new Machine(debugUserProg,
+			  (numCpus > 1) ? ReferenceEngine : simEngine);
+    if (tlbSize > 0)
+	machine->EnableTLB(tlbSize, tlbWays, tlbPolicy);
+    cpu[0]->tlb = machine->tlb;
+    for (int i = 1; i < numCpus && tlbSize > 0; i++) {
+	cpu[i]->tlb = new TranslationEntry[tlbSize];	// each CPU has its own
+	for (int j = 0; j < tlbSize; j++)
+	    cpu[i]->tlb[j].valid = FALSE;
+    }
+    machine->icache = icache;
+    machine->dcache = dcache;
     synchConsoleIn = new SynchConsoleInput(consoleIn); // input from stdin
     synchConsoleOut = new SynchConsoleOutput(consoleOut); // output to stdout
     synchDisk = new SynchDisk();    //
 
-    // [ADD] initialize physical page in use
-    for(int i=0 ; i<NumPhysPages ; i++){
-        physInUse[i] = false;
+    frames = new FrameAllocator(NumPhysPages);
+    textCache = new TextCache();
+    processes = new ProcessTable();
+    for (int i = 0; i < NumPhysPages; i++)
+	frameOwner[i] = NULL;
+    if (zeroFill && !demandPaging) {	// -vm fills pages as they are
+					// touched anyway
+	zeroFrame = frames->Allocate();	// never freed
+	bzero(&machine->mainMemory[zeroFrame * PageSize], PageSize);
+    }
+    if (demandPaging) {
+	swapSpace = new SwapSpace();
+	pagingLock = new Lock("paging");
     }
-    // [END-OF-ADD]
 
 #ifdef FILESYS_STUB
     fileSystem = new FileSystem();
@@ -143,16 +327,32 @@ Kernel::~Kernel()
     delete stats;
     delete interrupt;
     delete scheduler;
+    delete heldThreads;
     delete alarm;
+    for (int i = 0; i < numCpus; i++) {
+	if (i > 0)
+	    delete cpu[i]->alarm;
+	if (cpu[i]->tlb != machine->tlb)	// the Machine deletes its own
+	    delete [] cpu[i]->tlb;
+	delete cpu[i];
+    }
     delete machine;
     delete synchConsoleIn;
     delete synchConsoleOut;
+    delete processes;
+    delete textCache;
+    delete frames;
+    delete swapSpace;
+    delete replacement;
+    delete pagingLock;
     delete synchDisk;
     delete fileSystem;
     // [ADD MP3] according to spec instruction 3
     // delete postOfficeIn;
     // delete postOfficeOut;
     // [END-of-ADD]
+    delete trace;		// write out the last events, if tracing
+    delete eventLog;
     
     Exit(0);
 }
@@ -269,6 +469,9 @@ Kernel::NetworkTest() {
 void ForkExecute(Thread *t)
 {
 	if ( !t->space->Load(t->getName()) ) {
+	kernel->processes->Exit(t->space->GetId(), -1);
+	delete t->space;
+	t->space = NULL;
     	return;             // executable not found
     }
 	
@@ -276,9 +479,36 @@ void ForkExecute(Thread *t)
 
 }
 
+//----------------------------------------------------------------------
+// ResumeExecute
+// 	Start a thread restored from a checkpoint, or a clone: go back to
+//	running its user program where the checkpoint (or the original)
+//	left it.
+//----------------------------------------------------------------------
+
+static void
+ResumeExecute(Thread *t)
+{
+    t->space->Resume();
+}
+
+//----------------------------------------------------------------------
+// StartExecute
+// 	Start a child made by the Exec system call: its program is
+//	already loaded (see Kernel::ExecChild), so just run it.
+//----------------------------------------------------------------------
+
+static void
+StartExecute(Thread *t)
+{
+    t->space->Execute(t->getName());
+}
+
 void Kernel::ExecAll()
 {
-	for (int i=1;i<=execfileNum;i++) {
+	if (restoreFile != NULL)	// resume those programs instead
+		Restore();
+	for (int i=1;i<=execfileNum && restoreFile == NULL;i++) {
 		int a = Exec(execfile[i], initPriority[i]); // [ADD MP3] for sending initial priority
 	}
 	currentThread->Finish();
@@ -290,6 +520,7 @@ int Kernel::Exec(char* name, int initP)
 {
 	t[threadNum] = new Thread(name, threadNum, initP); // [ADD MP3] sending initial priority
     t[threadNum]->space = new AddrSpace();
+    t[threadNum]->space->SetId(processes->Add(0));
     t[threadNum]->Fork((VoidFunctionPtr) &ForkExecute, (void *)t[threadNum]);
 	threadNum++;
 
@@ -320,3 +551,302 @@ int Kernel::Exec(char* name, int initP)
 //    Kernel::Run();
 //  cout << "after ThreadedKernel:Run();" << endl;  // unreachable
 }
+
+//----------------------------------------------------------------------
+// Kernel::ExecChild
+// 	The Exec system call: start a new thread running the program
+//	"name", as a child of the current process, at the same priority.
+//	Return its process id, or -1 if there is no such program, not
+//	enough memory for it, or no room in the process table.
+//
+//	The program is loaded here, by the parent, so that the child
+//	only ever starts if it can run, and a failure is returned by
+//	the call itself rather than by a later Join.
+//----------------------------------------------------------------------
+
+int
+Kernel::ExecChild(char *name)
+{
+    AddrSpace *space = new AddrSpace();
+    Thread *thread;
+    int id;
+
+    if (!space->Load(name)
+	  || (id = processes->Add(currentThread->space->GetId())) < 0) {
+	delete space;			// gives back any frames it got
+	return -1;
+    }
+    space->SetId(id);
+    thread = new Thread(strcpy(new char[strlen(name) + 1], name),
+			threadNum++, currentThread->GetPriority());
+    thread->space = space;
+    thread->Fork((VoidFunctionPtr) &StartExecute, (void *) thread);
+    return id;
+}
+
+//----------------------------------------------------------------------
+// Kernel::ForkChild
+// 	The Fork system call: start a new thread running a clone of the
+//	current process (see AddrSpace::Clone), as its child.  The clone
+//	goes on from the same point, but gets 0 back from the call.
+//	Return its process id, or -1 if the process table is full, or
+//	with "-vm", which cannot clone.
+//----------------------------------------------------------------------
+
+int
+Kernel::ForkChild()
+{
+    Thread *thread;
+    int id;
+
+    if (demandPaging || (id = processes->Add(currentThread->space->GetId())) < 0)
+	return -1;
+    thread = new Thread(currentThread->getName(), threadNum++,
+			currentThread->GetPriority());
+    thread->space = new AddrSpace();
+    thread->space->Clone(currentThread->space);
+    thread->space->SetId(id);
+    thread->Fork((VoidFunctionPtr) &ResumeExecute, (void *) thread);
+    return id;
+}
+
+// A checkpoint file starts with these, so we don't resume from a
+// checkpoint of some other build of Nachos.
+
+static const int CheckpointMagic = 0x4e434b50;	// "NCKP"
+
+static int checkpointHeader[] = { CheckpointMagic, NumPhysPages, PageSize,
+				  NumTotalRegs, sizeof(Statistics) };
+
+//----------------------------------------------------------------------
+// Kernel::Checkpoint
+// 	Save the state of the simulation to "checkpointFile", so that a
+//	later run can resume from it with "-restore": the statistics,
+//	when each pending interrupt is due, all of physical memory, and
+//	for each thread, its scheduling state, page table and user
+//	registers.  The disk image goes in too.
+//
+//	We can't save the host state of a thread (its kernel stack), so
+//	this only works when every thread is either about to run its
+//	next user instruction, or has not started yet.  We are called
+//	between two user instructions of the current thread, or as it
+//	is about to make a system call; the others must have been
+//	stopped the same way.  If one is blocked, or running in the
+//	kernel, return FALSE; we will try again later.  Once the
+//	checkpoint is written, the threads held in HoldSyscall go on.
+//
+//	Open files, the console and the network are not saved.
+//----------------------------------------------------------------------
+
+bool
+Kernel::Checkpoint()
+{
+    List<Thread *> *threads;
+    ListIterator<Thread *> *iter;
+    Thread *thread;
+    int fd, n, diskFd, diskSize;
+    char diskName[32], *diskImage;
+    IntStatus oldLevel;
+
+    if (numCpus > 1 || currentThread->space == NULL
+	  || scheduler->NumWaiting() > (int) heldThreads->NumInList())
+	return FALSE;
+    threads = scheduler->ReadyThreads();
+    for (iter = new ListIterator<Thread *>(threads); !iter->IsDone();
+	 iter->Next()) {
+	thread = iter->Item();
+	if (thread->space == NULL
+	      || (thread->space->IsLoaded() && !thread->preemptedInUserMode)) {
+	    delete iter;
+	    delete threads;
+	    return FALSE;
+	}
+    }
+    delete iter;
+    for (iter = new ListIterator<Thread *>(heldThreads); !iter->IsDone();
+	 iter->Next())
+	threads->Append(iter->Item());
+    delete iter;
+    threads->Prepend(currentThread);	// it gets to run first again
+    currentThread->space->SaveState(TRUE);  // copy its registers
+
+    fd = OpenForWrite(checkpointFile);
+    ::WriteFile(fd, (char *) checkpointHeader, sizeof(checkpointHeader));
+    ::WriteFile(fd, (char *) stats, sizeof(Statistics));
+    interrupt->Checkpoint(fd);
+    ::WriteFile(fd, machine->mainMemory, MemorySize);
+    frames->Checkpoint(fd);
+    ::WriteFile(fd, (char *) &zeroFrame, sizeof(int));
+    processes->Checkpoint(fd);
+
+    n = threads->NumInList();
+    ::WriteFile(fd, (char *) &n, sizeof(int));
+    for (iter = new ListIterator<Thread *>(threads); !iter->IsDone();
+	 iter->Next()) {
+	thread = iter->Item();
+	n = strlen(thread->getName());
+	::WriteFile(fd, (char *) &n, sizeof(int));
+	::WriteFile(fd, thread->getName(), n);
+	n = thread->getID();
+	::WriteFile(fd, (char *) &n, sizeof(int));
+	thread->Checkpoint(fd);
+	n = thread->space->GetId();
+	::WriteFile(fd, (char *) &n, sizeof(int));
+	n = thread->space->IsLoaded();
+	::WriteFile(fd, (char *) &n, sizeof(int));
+	if (n)
+	    thread->space->Checkpoint(fd);
+    }
+    delete iter;
+    delete threads;
+
+    sprintf(diskName, "DISK_%d", hostName);
+    diskFd = OpenForReadWrite(diskName, FALSE);
+    diskSize = 0;
+    if (diskFd >= 0) {
+	Lseek(diskFd, 0, 2);
+	diskSize = Tell(diskFd);
+    }
+    ::WriteFile(fd, (char *) &diskSize, sizeof(int));
+    if (diskSize > 0) {
+	diskImage = new char[diskSize];
+	Lseek(diskFd, 0, 0);
+	Read(diskFd, diskImage, diskSize);
+	::WriteFile(fd, diskImage, diskSize);
+	delete [] diskImage;
+    }
+    if (diskFd >= 0)
+	Close(diskFd);
+    Close(fd);
+
+    cout << "Checkpoint written to " << checkpointFile << " at tick "
+	 << stats->totalTicks << "\n";
+    cout.flush();
+    checkpointFile = NULL;		// we are done
+
+    oldLevel = interrupt->SetLevel(IntOff);	// let the held threads go
+    while (!heldThreads->IsEmpty())
+	scheduler->ReadyToRun(heldThreads->RemoveFront());
+    (void) interrupt->SetLevel(oldLevel);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Kernel::HoldSyscall
+// 	Called as the current thread is about to make a system call.
+//	If a checkpoint is due, take it now, or if some other thread is
+//	not ready for it, put the current thread to sleep until it is
+//	taken, and return TRUE: the system call has not been made, and
+//	since the PC still points at it, the thread will make it again.
+//
+//	Holding threads this way lets the ones in the kernel finish
+//	their system calls, without more of them starting new ones.
+//	Except that a thread waiting in Join only finishes when the
+//	process it joins exits; while there is one, we hold no one.
+//----------------------------------------------------------------------
+
+bool
+Kernel::HoldSyscall()
+{
+    IntStatus oldLevel;
+
+    if (checkpointFile == NULL || numCpus > 1
+	  || stats->totalTicks < checkpointTick)
+	return FALSE;
+    if (processes->NumJoining() > 0)	// it may be waiting for us: no
+	return FALSE;			// checkpoint until it is done
+    if (Checkpoint())
+	return FALSE;
+    oldLevel = interrupt->SetLevel(IntOff);
+    heldThreads->Append(currentThread);
+    currentThread->preemptedInUserMode = TRUE;
+    currentThread->Sleep(FALSE);
+    currentThread->preemptedInUserMode = FALSE;
+    (void) interrupt->SetLevel(oldLevel);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Kernel::Restore
+// 	Resume the simulation saved by Checkpoint in "restoreFile":
+//	put back the statistics, the times the pending interrupts are
+//	due, memory and disk image, and re-create each thread, ready to
+//	go on with its user program.  A thread that had not started yet
+//	starts its program from the beginning.
+//
+//	Called from the main thread, instead of starting the programs
+//	named on the command line.
+//----------------------------------------------------------------------
+
+void
+Kernel::Restore()
+{
+    int header[sizeof(checkpointHeader) / sizeof(int)];
+    int fd, n, loaded, length, id, processId, diskFd, diskSize;
+    char diskName[32], *name, *diskImage;
+    Thread *thread;
+    IntStatus oldLevel;
+
+    oldLevel = interrupt->SetLevel(IntOff);	// nothing runs until we are
+						// done
+    fd = OpenForReadWrite(restoreFile, FALSE);
+    if (fd < 0) {
+	cerr << "Unable to open checkpoint " << restoreFile << "\n";
+	Abort();
+    }
+    if (ReadPartial(fd, (char *) header, sizeof(header)) != sizeof(header)
+	  || memcmp(header, checkpointHeader, sizeof(header)) != 0) {
+	cerr << restoreFile << " is not a checkpoint of this Nachos\n";
+	Abort();
+    }
+    Read(fd, (char *) stats, sizeof(Statistics));
+    stats->pageTableBytes = 0;		// the page tables are made anew
+    interrupt->Restore(fd);		// the timer goes off when it would have
+    Read(fd, machine->mainMemory, MemorySize);
+    frames->Restore(fd);
+    Read(fd, (char *) &zeroFrame, sizeof(int));	// the saved pages map
+    processes->Restore(fd);			// the saved one, if any
+    for (int i = 0; i < NumPhysPages; i++)
+	machine->InvalidateDecodedPage(i);	// the code is all new
+
+    Read(fd, (char *) &n, sizeof(int));
+    for (int i = 0; i < n; i++) {
+	Read(fd, (char *) &length, sizeof(int));
+	name = new char[length + 1];
+	Read(fd, name, length);
+	name[length] = '\0';
+	Read(fd, (char *) &id, sizeof(int));
+	thread = new Thread(name, id, 0);
+	thread->Restore(fd);
+	thread->space = new AddrSpace();
+	Read(fd, (char *) &processId, sizeof(int));
+	thread->space->SetId(processId);
+	Read(fd, (char *) &loaded, sizeof(int));
+	if (loaded) {
+	    thread->space->Restore(fd);
+	    thread->Fork((VoidFunctionPtr) &ResumeExecute, (void *) thread);
+	} else {
+	    thread->Fork((VoidFunctionPtr) &ForkExecute, (void *) thread);
+	}
+	if (id < (int) (sizeof(t) / sizeof(t[0])))
+	    t[id] = thread;		// one of the "-e" programs
+	threadNum = max(threadNum, id + 1);
+    }
+
+    Read(fd, (char *) &diskSize, sizeof(int));
+    if (diskSize > 0) {
+	diskImage = new char[diskSize];
+	Read(fd, diskImage, diskSize);
+	sprintf(diskName, "DISK_%d", hostName);
+	diskFd = OpenForReadWrite(diskName, TRUE);
+	::WriteFile(diskFd, diskImage, diskSize);
+	Close(diskFd);
+	delete [] diskImage;
+    }
+    Close(fd);
+
+    cout << "Restored " << n << " threads from " << restoreFile
+	 << " at tick " << stats->totalTicks << "\n";
+    cout.flush();
+    (void) interrupt->SetLevel(oldLevel);
+}
@@ -18,12 +18,21 @@
 #include "alarm.h"
 #include "filesys.h"
 #include "machine.h"
+#include "cpu.h"
 
 class PostOfficeInput;
 class PostOfficeOutput;
 class SynchConsoleInput;
 class SynchConsoleOutput;
 class SynchDisk;
+class EventLog;
+class AddrSpace;
+class SwapSpace;
+class Replacement;
+class FrameAllocator;
+class TextCache;
+class ProcessTable;
+class Lock;
 
 typedef int OpenFileId;
 
@@ -38,6 +47,16 @@ class Kernel {
 				// refers to "kernel" as a global
     void ExecAll();
     int Exec(char* name, int initP);
+    int ExecChild(char *name);	// Run "name" as a child of the current
+				// process; its id, or -1 on error
+    int ForkChild();		// Run a clone of the current process
+				// as its child; its id, or -1
+    bool Checkpoint();		// Save the user programs' state, if
+				// they can be resumed from it
+    void Restore();		// Resume the user programs saved by
+				// Checkpoint
+    bool HoldSyscall();		// Wait for a checkpoint that is due,
+				// before making a system call
     void ThreadSelfTest();	// self test of threads and synchronization
 	
     void ConsoleTest();         // interactive console self test
@@ -57,6 +76,9 @@ class Kernel {
 // they're global variables used everywhere.
 
     Thread *currentThread;	// the thread holding the CPU
+    int numCpus;		// # of simulated CPUs
+    int currentCpu;		// the CPU being simulated
+    Cpu *cpu[MaxCpus];		// the state of each CPU
     Scheduler *scheduler;	// the ready list
     Interrupt *interrupt;	// interrupt status
     Statistics *stats;		// performance metrics
@@ -70,10 +92,40 @@ class Kernel {
     PostOfficeOutput *postOfficeOut;
 
     int hostName;               // machine identifier
-
-    // [ADD] For checking whether the physical space is in use
-    bool physInUse[NumPhysPages];
-    // [END-OF-ADD]
+    bool profiling;		// profile each user program?
+    bool softTLBStats;		// print the soft TLB's hits and misses?
+    EventLog *eventLog;		// inputs from the host, recorded or
+				// replayed; NULL if neither
+    char *checkpointFile;	// where to save the simulation, at the
+    int checkpointTick;		// first chance after this time; NULL
+				// if no checkpoint is wanted
+
+    FrameAllocator *frames;	// which physical page frames are in use
+    bool contiguousFrames;	// load each program into a run of
+				// frames, if there is one?
+    TextCache *textCache;	// the code of the programs running, to
+				// share with more copies of them
+    ProcessTable *processes;	// the user programs running, and those
+				// that exited but are not joined yet
+
+    int stackLimit;		// how far user stacks may grow, in bytes
+    PageTableKind pageTableKind; // the shape of user page tables
+    int zeroFrame;		// with -zf, a frame of zeroes shared by
+				// the pages that were not written yet;
+				// -1 if none
+    bool demandPaging;		// page user programs in on demand?
+    int clusterPages;		// with demand paging, how many pages a
+				// fault brings in at most
+    AddrSpace *frameOwner[NumPhysPages]; // with demand paging, the space
+    int frameVpn[NumPhysPages];	// and virtual page in each frame; the
+				// owner is NULL if the frame is free,
+				// or in transit
+    Replacement *replacement;	// picks the frame to page out; NULL
+				// unless demand paging
+    SwapSpace *swapSpace;	// where pages go when they are paged out
+    Lock *pagingLock;		// one page fault is handled at a time, so
+				// that a page being written out is not
+				// read back in before the write
 
   private:
 
@@ -84,9 +136,20 @@ class Kernel {
 	int threadNum;
     bool randomSlice;		// enable pseudo-random time slicing
     bool debugUserProg;         // single step user program
+    SimEngine simEngine;	// engine used to run user instructions
+    int tlbSize;		// # of TLB entries; 0 for a page table
+    int tlbWays;		// TLB associativity
+    TLBPolicy tlbPolicy;	// TLB replacement policy
+    bool zeroFill;		// map pages of zeroes to zeroFrame until
+				// they are written?
+    Cache *icache;		// caches to simulate, if any; handed to
+    Cache *dcache;		// the Machine
     double reliability;         // likelihood messages are dropped
     char *consoleIn;            // file to read console input from
     char *consoleOut;           // file to send console output to
+    char *restoreFile;		// checkpoint to resume from, if any
+    List<Thread *> *heldThreads; // threads held at a system call until
+				// the checkpoint is taken
 #ifndef FILESYS_STUB
     bool formatFlag;          // format the disk if this is true
 #endif
@@ -3,16 +3,84 @@
 //	operating system kernel.  
 //
 // Usage: nachos -d <debugflags> -rs <random seed #>
-//              -s -x <nachos file> -ci <consoleIn> -co <consoleOut>
+//              -s -sim <engine> -smp <cpus> -tlb <size> <ways> <policy>
+//              -icache <line> <sets> <ways>
+//              -dcache <line> <sets> <ways> <policy> -prof -stlb
+//              -vm <policy> -cluster <pages> -zf -contig -stack <bytes>
+//              -pt <kind>
+//              -ckpt <tick> <checkpoint file> -restore <checkpoint file>
+//              -record <event log> -replay <event log>
+//              -x <nachos file>
+//              -ci <consoleIn> -co <consoleOut>
 //              -f -cp <unix file> <nachos file>
 //              -p <nachos file> -r <nachos file> -l -D
 //              -n <network reliability> -m <machine id>
-//              -z -K -C -N
+//              -z -K -C -N -trace <trace file> -dt <trace file>
 //
 //    -d causes certain debugging messages to be printed (see debug.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
 //    -z prints the copyright message
 //    -s causes user programs to be executed in single-step mode
+//    -sim selects how user instructions are simulated: "ref" (the
+//	default) runs one instruction at a time, "threaded" runs
+//	straight-line blocks with threaded dispatch, "jit" also compiles
+//	hot runs of ALU instructions to host code, "diff" checks each
+//	compiled run against the reference engine as it goes, and "batch"
+//	is the reference engine charging time in bulk between interrupts
+//    -smp simulates a multiprocessor with <cpus> CPUs (at most 8), each
+//	with its own ready queues and timer; the CPUs take turns, one
+//	instruction at a time, and all run the "ref" engine
+//    -tlb makes user programs translate addresses through a TLB of
+//	<size> entries, in sets of <ways>, instead of a page table; the
+//	kernel refills it on a miss, replacing entries by <policy>
+//	("random", "fifo", "lru" or "clock")
+//    -icache and -dcache simulate the timing of an instruction and a
+//	data cache of <sets> sets of <ways> lines of <line> bytes; the
+//	data cache either writes back ("wb") or writes through ("wt").
+//	Cache misses stall user programs, and show up as extra user ticks
+//    -prof counts the instructions each user program executes, by
+//	address, and prints where it spent its time when it exits; the
+//	calling context is written to "<program>.<process id>.folded"
+//	for flame graphs
+//    -stlb prints how often the simulator found a translation in its
+//	soft TLB (see machine.h), and how often it had to translate, in
+//	the statistics at the end
+//    -vm pages user programs in from their files as they touch them,
+//	and pages them out to swap space on the Nachos disk when memory
+//	is full, so that they may need more than NumPhysPages frames in
+//	all; <policy> picks the page to page out: "fifo", "clock",
+//	"eclock" (enhanced clock), "aging" (approximate LRU) or "wsclock"
+//	(see replacement.h).  It cannot be combined with -smp, -ckpt or
+//	-restore
+//    -cluster makes a page fault on a page in swap space bring in up
+//	to <pages> pages (at most 8) with -vm: the one faulted on, and
+//	those after it that are in the next slots, which the disk reads
+//	from its track buffer.  Each program prints, when it exits, how
+//	many pages came in ahead of a fault, and how many of them it
+//	used (hits) or not (waste)
+//    -zf does not give the pages of a program that start out as
+//	zeroes (uninitialized data and the stack) frames of their own
+//	until they are written: until then, they all share one frame of
+//	zeroes.  With -vm, pages get their frames when touched anyway
+//    -contig loads each user program into a run of consecutive frames,
+//	if there is one long enough, instead of the lowest free frames
+//    -stack lets the stack of each user program grow to <bytes> (8192
+//	by default); it starts out with 1024, and grows a page at a time
+//	as it is touched.  A program that goes past it gets a "Stack
+//	overflow", instead of running over its heap
+//    -pt picks the shape of the page tables of user programs: "linear"
+//	(the default), "2level" or "hashed" (see pagetable.h).  With the
+//	last two, the statistics at the end tell how many lookups the
+//	machine made in them, how many memory references those took, and
+//	the most bytes the page tables took at once
+//    -ckpt saves the state of the user programs, memory, and the disk to
+//	<checkpoint file> at the first chance after <tick>, and goes on
+//    -restore resumes the user programs saved in <checkpoint file>,
+//	instead of starting the ones named by -e and -ep
+//    -record logs the inputs that come from the host (console input,
+//	network packets, and the random time slices of -rs) to <event log>
+//    -replay takes those inputs from <event log> instead, at the ticks
+//	they were recorded at, so that the run repeats the recorded one
 //    -x runs a user program
 //    -ci specify file for console input (stdin is the default)
 //    -co specify file for console output (stdout is the default)
@@ -21,6 +89,10 @@
 //    -K run a simple self test of kernel threads and synchronization
 //    -C run an interactive console test
 //    -N run a two-machine network test (see Kernel::NetworkTest)
+//    -trace records the scheduler's "-d z" events to <trace file>, in
+//	binary, instead of printing them as they happen
+//    -dt prints the events in <trace file> as "-d z" would have, and
+//	exits
 //
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
@@ -45,6 +117,7 @@
 #include "filesys.h"
 #include "openfile.h"
 #include "sysdep.h"
+#include "trace.h"
 
 // global variables
 Kernel *kernel;
@@ -207,6 +280,16 @@ main(int argc, char **argv)
 	else if (strcmp(argv[i], "-N") == 0) {
 	    networkTestFlag = TRUE;
 	}
+	else if (strcmp(argv[i], "-trace") == 0) {
+	    ASSERT(i + 1 < argc);
+	    trace = new Trace(argv[i + 1]);
+	    i++;
+	}
+	else if (strcmp(argv[i], "-dt") == 0) {
+	    ASSERT(i + 1 < argc);
+	    Trace::Decode(argv[i + 1]);
+	    return 0;
+	}
 #ifndef FILESYS_STUB
 	else if (strcmp(argv[i], "-cp") == 0) {
 	    ASSERT(i + 2 < argc);
@@ -235,6 +318,7 @@ main(int argc, char **argv)
             cout << "Partial usage: nachos [-z -d debugFlags]\n";
             cout << "Partial usage: nachos [-x programName]\n";
 	    cout << "Partial usage: nachos [-K] [-C] [-N]\n";
+	    cout << "Partial usage: nachos [-trace traceFile] [-dt traceFile]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-cp UnixFile NachosFile]\n";
             cout << "Partial usage: nachos [-p fileName] [-r fileName]\n";
@@ -4,7 +4,8 @@
 //
 // 	These routines assume that interrupts are already disabled.
 //	If interrupts are disabled, we can assume mutual exclusion
-//	(since we are on a uniprocessor).
+//	from this CPU; the ready lists, which other CPUs can also
+//	reach, are further guarded by a spin lock.
 //
 // 	NOTE: We can't use Locks to provide mutual exclusion here, since
 // 	if we needed to wait for a lock, and the lock was busy, we would 
@@ -20,7 +21,9 @@
 
 #include "copyright.h"
 #include "debug.h"
+#include "trace.h"
 #include "scheduler.h"
+#include "synch.h"
 #include "main.h"
 
 //----------------------------------------------------------------------
@@ -33,13 +36,16 @@ Scheduler::Scheduler()
 { 
     // [ADD MP3] Now initialize L1~L3 ready list
     // readyList = new List<Thread *>; 
-    level1List = new SortedList<Thread *>(Level1Comp);
-    level2List = new SortedList<Thread *>(Level2Comp);
-    level3List = new List<Thread *>;
+    for (int i = 0; i < MaxCpus; i++) {
+        level1List[i] = new SortedList<Thread *>(Level1Comp);
+        level2List[i] = new SortedList<Thread *>(Level2Comp);
+        level3List[i] = new List<Thread *>;
+    }
     WaitingList = new List<Thread *>;
     tmp = new List<Thread *>;
     // [END-of-ADD]
     toBeDestroyed = NULL;
+    readyLock = new SpinLock("ready lists");
 } 
 
 //----------------------------------------------------------------------
@@ -51,10 +57,13 @@ Scheduler::~Scheduler()
 { 
     // [ADD MP3]
     // delete readyList; 
-    delete level1List;
-    delete level2List;
-    delete level3List;
+    for (int i = 0; i < MaxCpus; i++) {
+        delete level1List[i];
+        delete level2List[i];
+        delete level3List[i];
+    }
     // [END-of-ADD]
+    delete readyLock;
 } 
 
 //----------------------------------------------------------------------
@@ -99,25 +108,28 @@ Scheduler::Level2Comp(Thread *x, Thread *y){
 //	Update queue level according to priority.
 //  Assume the priority must within 0~149.
 //  0~49 for L1; 50~99 for L2; 100~149 for L3.
+//  The lists are those of the CPU the thread last ran on.
 //----------------------------------------------------------------------
 
 void
 Scheduler::InsertToReadyList (Thread *thread) {
     int priority = thread->GetPriority();
+    int cpu = thread->getCpu();
 
     if(priority <= 49) {
         thread->UpdateQueueLevel(3);
-        level3List->Append(thread);
+        level3List[cpu]->Append(thread);
     }
     else if(priority <= 99) {
         thread->UpdateQueueLevel(2);
-        level2List->Insert(thread);
+        level2List[cpu]->Insert(thread);
     }
     else {
         thread->UpdateQueueLevel(1);
-        level1List->Insert(thread);
+        level1List[cpu]->Insert(thread);
     }
-    DEBUG(dbgQLevel, "[A] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is inserted into queue L[" << thread->GetQueueLevel() << "]");
+    TRACE(kernel->stats->GlobalTicks(), TraceInsert, thread->getID(),
+	  thread->GetQueueLevel(), 0, 0);
 }
 
 //----------------------------------------------------------------------
@@ -139,6 +151,7 @@ Scheduler::ReadyToRun (Thread *thread)
 	//cout << "Putting thread on ready list: " << thread->getName() << endl ;
     thread->setStatus(READY);
 
+    readyLock->Acquire();
     // [ADD MP3]
     // readyList->Append(thread);
     if(!WaitingList->IsEmpty() && WaitingList->IsInList(thread)){
@@ -146,50 +159,103 @@ Scheduler::ReadyToRun (Thread *thread)
     }
     InsertToReadyList(thread); // Insert thread to ready list
     // [END-of-ADD]
+    readyLock->Release();
 }
 
 //----------------------------------------------------------------------
-// Scheduler::FindNextToRun
-// 	Return the next thread to be scheduled onto the CPU.
-//	If there are no ready threads, return NULL.
-// Side effect:
-//	Thread is removed from the ready list.
-//
-//  Running -> Ready
-//  Running -> Waiting
-//  Running -> Terminated
+// Scheduler::RemoveFromReadyList
+// 	Remove the thread that should run next on CPU "cpu" from its
+//	ready lists, and return it; NULL if they are empty.
 //----------------------------------------------------------------------
 
 Thread *
-Scheduler::FindNextToRun ()
+Scheduler::RemoveFromReadyList (int cpu)
 {
-    ASSERT(kernel->interrupt->getLevel() == IntOff);
-
     // [ADD MP3]
     Thread *nextThread = NULL;
-    if (level1List->IsEmpty()){
-        if(level2List->IsEmpty()){
-            if(level3List->IsEmpty()){
+    if (level1List[cpu]->IsEmpty()){
+        if(level2List[cpu]->IsEmpty()){
+            if(level3List[cpu]->IsEmpty()){
                 nextThread = NULL;
             }
             else{
-                nextThread = level3List->RemoveFront();
+                nextThread = level3List[cpu]->RemoveFront();
             }
         }
         else{
-            nextThread = level2List->RemoveFront();
+            nextThread = level2List[cpu]->RemoveFront();
         }
     }
     else{
-        nextThread = level1List->RemoveFront();
+        nextThread = level1List[cpu]->RemoveFront();
     }
 
     if(nextThread != NULL) {
-        DEBUG(dbgQLevel, "[B] Tick [" << kernel->stats->totalTicks << "]: Thread [" << nextThread->getID() << "] is removed from queue L[" << nextThread->GetQueueLevel() << "]");
+        TRACE(kernel->stats->GlobalTicks(), TraceRemove, nextThread->getID(),
+	      nextThread->GetQueueLevel(), 0, 0);
     }
 
     return nextThread;
     // [END-of-ADD]
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NumReady
+// 	Return the number of threads on CPU "cpu"'s ready lists.
+//----------------------------------------------------------------------
+
+int
+Scheduler::NumReady (int cpu)
+{
+    return level1List[cpu]->NumInList() + level2List[cpu]->NumInList()
+	    + level3List[cpu]->NumInList();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::FindNextToRun
+// 	Return the next thread to be scheduled onto the CPU.
+//	If there are no ready threads, return NULL.
+//
+//	If our own ready lists are empty, we steal the next thread of
+//	the CPU with the most ready threads, and the thread then stays
+//	with us.  On a uniprocessor, there is no one to steal from.
+// Side effect:
+//	Thread is removed from the ready list.
+//
+//  Running -> Ready
+//  Running -> Waiting
+//  Running -> Terminated
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::FindNextToRun ()
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+    int cpu = kernel->currentCpu;
+    Thread *nextThread;
+    int victim, most;
+
+    readyLock->Acquire();
+    nextThread = RemoveFromReadyList(cpu);
+    if (nextThread == NULL) {
+        victim = -1;
+        most = 0;
+        for (int i = 0; i < kernel->numCpus; i++) {
+            if (NumReady(i) > most) {
+                victim = i;
+                most = NumReady(i);
+            }
+        }
+        if (victim != -1) {
+            nextThread = RemoveFromReadyList(victim);
+            DEBUG(dbgThread, "CPU " << cpu << " steals thread " << nextThread->getName() << " from CPU " << victim);
+            nextThread->setCpu(cpu);
+            kernel->cpu[cpu]->steals++;
+        }
+    }
+    readyLock->Release();
+    return nextThread;
 
     // if (readyList->IsEmpty()) {
 	// 	return NULL;
@@ -223,7 +289,8 @@ Scheduler::Run (Thread *nextThread, bool finishing)
     // [ADD MP3]
     if(nextThread != oldThread) {
         oldThread->UpdateRunningTicks();
-        DEBUG(dbgQLevel, "[E] Tick [" << kernel->stats->totalTicks << "]: Thread [" << nextThread->getID() << "] is now selected for execution, thread [" << oldThread->getID() << "] is replaced, and it has executed [" << oldThread->GetRunningTicks() << "] ticks");
+        TRACE(kernel->stats->GlobalTicks(), TraceSwitch, nextThread->getID(),
+	      oldThread->getID(), oldThread->GetRunningTicks(), 0);
     }
     if(oldThread->getStatus() == BLOCKED) {
         // come from sleep, which means running -> waiting
@@ -298,6 +365,72 @@ Scheduler::CheckToBeDestroyed()
     }
 }
  
+//----------------------------------------------------------------------
+// Scheduler::SwitchCpu
+// 	On a multiprocessor, let the CPU that is furthest behind in
+//	simulated time run, if the CPU being simulated has got more than
+//	CpuSkew ticks ahead of it.  Called between user instructions, and
+//	by idle CPUs, so a CPU never stops in the middle of the kernel.
+//
+//	Switching CPUs is like switching threads in Run, except that the
+//	thread we leave stays running -- on its own CPU, which is just
+//	not being simulated for now.  So we save its user state, and the
+//	interrupt level and machine status it was running with, and
+//	bring in the other CPU's clock, TLB and current thread.  The TLB
+//	is not flushed: each CPU keeps its own.  The clock we leave goes
+//	into the global one (see Statistics::GlobalTicks), if it is the
+//	furthest ahead so far.
+//
+//	We return once some other CPU switches back to ours.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SwitchCpu ()
+{
+    Interrupt *interrupt = kernel->interrupt;
+    Cpu *from = kernel->cpu[kernel->currentCpu];
+    Cpu *to = from;
+    Thread *oldThread = kernel->currentThread;
+    IntStatus oldLevel;
+    MachineStatus oldStatus;
+
+    from->clock = kernel->stats->totalTicks;
+    if (from->clock > kernel->stats->globalTicks)
+        kernel->stats->globalTicks = from->clock;
+    for (int i = 0; i < kernel->numCpus; i++) {
+        if (kernel->cpu[i]->clock < to->clock)
+            to = kernel->cpu[i];
+    }
+    if (from->clock - to->clock <= CpuSkew)
+        return;
+
+    oldLevel = interrupt->getLevel();
+    oldStatus = interrupt->getStatus();
+    interrupt->ChangeLevel(oldLevel, IntOff);
+    interrupt->setStatus(SystemMode);
+    if (oldThread->space != NULL) {
+        oldThread->SaveUserState();
+        oldThread->space->SaveState(TRUE);
+    }
+    from->currentThread = oldThread;
+
+    DEBUG(dbgThread, "Switching from CPU " << from->id << " at " << from->clock << " to CPU " << to->id << " at " << to->clock);
+    kernel->currentCpu = to->id;
+    kernel->stats->totalTicks = to->clock;
+    kernel->currentThread = to->currentThread;
+    kernel->machine->tlb = to->tlb;
+    SWITCH(oldThread, to->currentThread);
+
+    // we're back, running oldThread on our own CPU
+
+    if (oldThread->space != NULL) {
+        oldThread->RestoreUserState();
+        oldThread->space->RestoreState();
+    }
+    interrupt->setStatus(oldStatus);
+    interrupt->ChangeLevel(IntOff, oldLevel);
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Print
 // 	Print the scheduler state -- in other words, the contents of
@@ -309,9 +442,11 @@ Scheduler::Print()
     cout << "Ready list contents:\n";
     // [ADD MP3]
     // readyList->Apply(ThreadPrint);
-    level1List->Apply(ThreadPrint);
-    level2List->Apply(ThreadPrint);
-    level3List->Apply(ThreadPrint);
+    for (int i = 0; i < kernel->numCpus; i++) {
+        level1List[i]->Apply(ThreadPrint);
+        level2List[i]->Apply(ThreadPrint);
+        level3List[i]->Apply(ThreadPrint);
+    }
     // [END-of-ADD]
 }
 
@@ -319,24 +454,28 @@ Scheduler::Print()
 //  [ADD MP3]
 //  Scheduler::UpdateAllWaitTicks
 //	Update all lists' thread waiting tick
+//  Only threads of the current CPU: the ticks are by its clock
 //----------------------------------------------------------------------
 void
 Scheduler::UpdateAllWaitTicks() {
-    ListIterator<Thread *> *iter = new ListIterator<Thread *>(level1List);
+    int cpu = kernel->currentCpu;
+
+    readyLock->Acquire();
+    ListIterator<Thread *> *iter = new ListIterator<Thread *>(level1List[cpu]);
 	for (; !iter->IsDone(); iter->Next()) {
 	    iter->Item()->UpdateWaitingTicks();
         iter->Item()->ResetStartWaitingTick();
     }
     delete iter;
 
-    iter = new ListIterator<Thread *>(level2List);
+    iter = new ListIterator<Thread *>(level2List[cpu]);
     for (; !iter->IsDone(); iter->Next()) {
 	    iter->Item()->UpdateWaitingTicks();
         iter->Item()->ResetStartWaitingTick();
     }
     delete iter;
 
-    iter = new ListIterator<Thread *>(level3List);
+    iter = new ListIterator<Thread *>(level3List[cpu]);
     for (; !iter->IsDone(); iter->Next()) {
 	    iter->Item()->UpdateWaitingTicks();
         iter->Item()->ResetStartWaitingTick();
@@ -345,10 +484,13 @@ Scheduler::UpdateAllWaitTicks() {
 
     iter = new ListIterator<Thread *>(WaitingList);
     for (; !iter->IsDone(); iter->Next()) {
-	    iter->Item()->UpdateWaitingTicks();
-        iter->Item()->ResetStartWaitingTick();
+        if (iter->Item()->getCpu() == cpu) {
+            iter->Item()->UpdateWaitingTicks();
+            iter->Item()->ResetStartWaitingTick();
+        }
     }
     delete iter;
+    readyLock->Release();
 }
 
 //----------------------------------------------------------------------
@@ -356,34 +498,41 @@ Scheduler::UpdateAllWaitTicks() {
 //  Scheduler::Aging
 //	Update queue all thread's waiting time in ready queue
 //  Perform aging once it's current waiting time is over 1500 again
+//  Only the current CPU's lists, as for UpdateAllWaitTicks
 //----------------------------------------------------------------------
 void
 Scheduler::Aging() {
+    int cpu = kernel->currentCpu;
+
+    readyLock->Acquire();
     // First update level3
     // we always remove all elements and append to the list again.
     // The reasome why we update like this is because level1 and level2 will sorted
     // DEBUG(dbgQLevel, "[X] Tick [" << kernel->stats->totalTicks << "]: start aging");
-    for(int i=0, end=level3List->NumInList() ; i<end ; i++){
-        Thread *cur = level3List->RemoveFront();
-        DEBUG(dbgQLevel, "[B] Tick [" << kernel->stats->totalTicks << "]: Thread [" << cur->getID() << "] is removed from queue L[" << cur->GetQueueLevel() << "]");
+    for(int i=0, end=level3List[cpu]->NumInList() ; i<end ; i++){
+        Thread *cur = level3List[cpu]->RemoveFront();
+        TRACE(kernel->stats->GlobalTicks(), TraceRemove, cur->getID(),
+	      cur->GetQueueLevel(), 0, 0);
         if(cur->GetWaitingTicks() >= 1500) {
             cur->UpdatePriority();
         }
         tmp->Append(cur);
     }
     // Then update level2
-    for(int i=0, end=level2List->NumInList() ; i<end ; i++){
-        Thread *cur = level2List->RemoveFront();
-        DEBUG(dbgQLevel, "[B] Tick [" << kernel->stats->totalTicks << "]: Thread [" << cur->getID() << "] is removed from queue L[" << cur->GetQueueLevel() << "]");
+    for(int i=0, end=level2List[cpu]->NumInList() ; i<end ; i++){
+        Thread *cur = level2List[cpu]->RemoveFront();
+        TRACE(kernel->stats->GlobalTicks(), TraceRemove, cur->getID(),
+	      cur->GetQueueLevel(), 0, 0);
         if(cur->GetWaitingTicks() >= 1500) {
             cur->UpdatePriority();
         }
         tmp->Append(cur);
     }
     // Finally update level 1
-    for(int i=0, end=level1List->NumInList() ; i<end ; i++){
-        Thread *cur = level1List->RemoveFront();
-        DEBUG(dbgQLevel, "[B] Tick [" << kernel->stats->totalTicks << "]: Thread [" << cur->getID() << "] is removed from queue L[" << cur->GetQueueLevel() << "]");
+    for(int i=0, end=level1List[cpu]->NumInList() ; i<end ; i++){
+        Thread *cur = level1List[cpu]->RemoveFront();
+        TRACE(kernel->stats->GlobalTicks(), TraceRemove, cur->getID(),
+	      cur->GetQueueLevel(), 0, 0);
         if(cur->GetWaitingTicks() >= 1500) {
             cur->UpdatePriority();
         }
@@ -394,6 +543,7 @@ Scheduler::Aging() {
         Thread *cur = tmp->RemoveFront();
         InsertToReadyList(cur);
     }
+    readyLock->Release();
     // DEBUG(dbgQLevel, "[X] Tick [" << kernel->stats->totalTicks << "]: end aging");
 }
 
@@ -404,5 +554,80 @@ Scheduler::Aging() {
 //----------------------------------------------------------------------
 void
 Scheduler::WaitAppend(Thread *x){
+    readyLock->Acquire();
     WaitingList->Append(x);
+    readyLock->Release();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ReadyThreads
+//	Return a new list of the threads ready to run on this CPU, in
+//	the order of its ready lists, L1 first.  The caller deletes it.
+//----------------------------------------------------------------------
+
+List<Thread *> *
+Scheduler::ReadyThreads()
+{
+    List<Thread *> *all = new List<Thread *>;
+    List<Thread *> *lists[3];
+    int cpu = kernel->currentCpu;
+
+    lists[0] = level1List[cpu];
+    lists[1] = level2List[cpu];
+    lists[2] = level3List[cpu];
+    for (int i = 0; i < 3; i++) {
+        ListIterator<Thread *> iter(lists[i]);
+        for (; !iter.IsDone(); iter.Next())
+            all->Append(iter.Item());
+    }
+    return all;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NumWaiting
+//	Return the number of threads that are blocked.
+//----------------------------------------------------------------------
+
+int
+Scheduler::NumWaiting()
+{
+    return WaitingList->NumInList();
+}
+
+//----------------------------------------------------------------------
+//  Scheduler::Level1Empty, Level2Empty, Level3Empty
+//	Return whether the current CPU's level 1, 2 or 3 list is empty
+//----------------------------------------------------------------------
+int
+Scheduler::Level1Empty() {
+    return level1List[kernel->currentCpu]->IsEmpty();
+}
+
+int
+Scheduler::Level2Empty() {
+    return level2List[kernel->currentCpu]->IsEmpty();
+}
+
+int
+Scheduler::Level3Empty() {
+    return level3List[kernel->currentCpu]->IsEmpty();
+}
+
+//----------------------------------------------------------------------
+//  Scheduler::GetLevel1Front, GetLevel2Front, GetLevel3Front
+//	Return the front of the current CPU's level 1, 2 or 3 list
+//----------------------------------------------------------------------
+Thread *
+Scheduler::GetLevel1Front() {
+    return level1List[kernel->currentCpu]->Front();
+}
+
+Thread *
+Scheduler::GetLevel2Front() {
+    return level2List[kernel->currentCpu]->Front();
+}
+
+Thread *
+Scheduler::GetLevel3Front() {
+    return level3List[kernel->currentCpu]->Front();
 }
\ No newline at end of file
@@ -12,10 +12,18 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "cpu.h"
+
+class SpinLock;
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
+//
+// Each CPU has its own ready queues.  A thread goes back on the queues
+// of the CPU it last ran on; a CPU with nothing to run takes a thread
+// from the CPU with the most.  Unless otherwise noted, operations are
+// on the queues of the CPU being simulated.
 
 class Scheduler {
   public:
@@ -31,38 +39,46 @@ class Scheduler {
     void CheckToBeDestroyed();// Check if thread that had been
     				// running needs to be deleted
     void Print();		// Print contents of ready list
+    void SwitchCpu();		// Let another CPU run, if we are too
+				// far ahead of it
     
     // SelfTest for scheduler is implemented in class Thread
 
     // [ADD MP3]
     static int Level1Comp(Thread *x, Thread *y);
     static int Level2Comp(Thread *x, Thread *y);
-    int Level1Empty() { return (level1List->IsEmpty()); }
-    int Level2Empty() { return (level2List->IsEmpty()); }
-    int Level3Empty() { return (level3List->IsEmpty()); }
-    Thread* GetLevel1Front() { return (level1List->Front()); }
-    Thread* GetLevel2Front() { return (level2List->Front()); }
-    Thread* GetLevel3Front() { return (level3List->Front()); }
+    int Level1Empty();
+    int Level2Empty();
+    int Level3Empty();
+    Thread* GetLevel1Front();
+    Thread* GetLevel2Front();
+    Thread* GetLevel3Front();
     void UpdateAllWaitTicks();
     void Aging();
     void WaitAppend(Thread *x);
     // [END-of-ADD]
+    List<Thread *> *ReadyThreads();	// the threads ready on this CPU
+    int NumWaiting();			// # of blocked threads
     
   private:
     // List<Thread *> *readyList;  // [ADD MP3] we no longer need readyList. ; queue of threads that are ready to run,
 				// but not running
 
     // [ADD MP3]
-    SortedList<Thread *> *level1List;   // level 1 ready list, sort by remaining CPU burst ticks
-    SortedList<Thread *> *level2List;   // level 2 ready list, sort by priority
-    List<Thread *> *level3List;         // level 3 ready list
+    SortedList<Thread *> *level1List[MaxCpus];   // level 1 ready list, sort by remaining CPU burst ticks
+    SortedList<Thread *> *level2List[MaxCpus];   // level 2 ready list, sort by priority
+    List<Thread *> *level3List[MaxCpus];         // level 3 ready list
     List<Thread *> *WaitingList;        // Waiting List. but we only record which thread are in waiting queue
     List<Thread *> *tmp;                // tmp buffer for aging
     void InsertToReadyList(Thread *thread);
+    Thread *RemoveFromReadyList(int cpu); // front of "cpu"'s ready lists
+    int NumReady(int cpu);              // # of threads ready on "cpu"
     // [END-of-ADD]
 
     Thread *toBeDestroyed;	// finishing thread to be destroyed
     				// by the next thread that runs
+    SpinLock *readyLock;	// guards the ready and waiting lists,
+				// which all CPUs share
 };
 
 #endif // SCHEDULER_H
@@ -28,6 +28,12 @@
 // The implementation of condition variables using semaphores is
 // a bit trickier, as explained below under Condition::Wait.
 //
+// On a multiprocessor, turning off interrupts is no longer enough,
+// since another CPU could be in the same code at the same time.  Our
+// simulated CPUs never are (see cpu.h), so the routines here still
+// get by with interrupts alone; but the data the CPUs share by design,
+// such as the scheduler's ready queues, is also guarded by spin locks.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -204,6 +210,66 @@ void Lock::Release()
     semaphore->V();
 }
 
+//----------------------------------------------------------------------
+// SpinLock::SpinLock
+// 	Initialize a spin lock, so that it can be used for synchronization
+//	between CPUs.  Initially, unlocked.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+SpinLock::SpinLock(char* debugName)
+{
+    name = debugName;
+    busy = 0;
+    holder = -1;
+}
+
+//----------------------------------------------------------------------
+// SpinLock::Acquire
+//	Wait until the lock is free, then set it to busy, with an atomic
+//	test-and-set.  Interrupts must already be off, so that no handler
+//	on this CPU can try to take the lock while we hold it.
+//
+//	Our CPUs take turns only between user instructions, never while
+//	one of them is in the kernel (see Scheduler::SwitchCpu), so we
+//	should never find the lock busy; we would only spin if the CPUs
+//	ran on host threads of their own.  Finding it held by our own
+//	CPU would spin forever, so that is checked first.
+//----------------------------------------------------------------------
+
+void SpinLock::Acquire()
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    ASSERT(!IsHeldByCurrentCpu());
+    while (__sync_lock_test_and_set(&busy, 1))
+	continue;			// spin
+    holder = kernel->currentCpu;
+}
+
+//----------------------------------------------------------------------
+// SpinLock::Release
+//	Set the lock to be free.  Only the CPU that acquired the lock
+//	may release it.
+//----------------------------------------------------------------------
+
+void SpinLock::Release()
+{
+    ASSERT(IsHeldByCurrentCpu());
+    holder = -1;
+    __sync_lock_release(&busy);
+}
+
+//----------------------------------------------------------------------
+// SpinLock::IsHeldByCurrentCpu
+//	Return TRUE if the CPU being simulated holds the lock.
+//----------------------------------------------------------------------
+
+bool SpinLock::IsHeldByCurrentCpu()
+{
+    return holder == kernel->currentCpu;
+}
+
 //----------------------------------------------------------------------
 // Condition::Condition
 // 	Initialize a condition variable, so that it can be 
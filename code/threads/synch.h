@@ -88,6 +88,39 @@ class Lock {
     Semaphore *semaphore;	// we use a semaphore to implement lock
 };
 
+// The following class defines a "spin lock", for the data that the
+// CPUs of a multiprocessor share (see cpu.h).  Turning interrupts off
+// keeps out the handlers of our own CPU, but not the other CPUs, so
+// the kernel must hold a spin lock too.  Unlike a Lock, waiting for a
+// spin lock never puts the thread to sleep, so the scheduler itself
+// can use one.
+//
+//	Acquire -- with interrupts off, wait until the lock is FREE,
+//		then set it to BUSY
+//
+//	Release -- set lock to be FREE
+//
+// Only the CPU that acquired the lock may release it.
+
+class SpinLock {
+  public:
+    SpinLock(char* debugName);	// initialize lock to be FREE
+    ~SpinLock() {}
+    char* getName() { return name; }	// debugging assist
+
+    void Acquire();
+    void Release();
+
+    bool IsHeldByCurrentCpu();	// return true if the current CPU
+				// holds this lock
+
+  private:
+    char *name;			// debugging assist
+    volatile int busy;		// 1 if BUSY; set with an atomic
+				// test-and-set
+    int holder;			// CPU holding the lock, -1 if FREE
+};
+
 // The following class defines a "condition variable".  A condition
 // variable does not have a value, but threads may be queued, waiting
 // on the variable.  These are only operations on a condition variable: 
@@ -21,6 +21,7 @@
 #include "switch.h"
 #include "synch.h"
 #include "sysdep.h"
+#include "trace.h"
 
 // this is put at the top of the execution stack, for detecting stack overflows
 const int STACK_FENCEPOST = 0xdedbeef;
@@ -37,6 +38,7 @@ Thread::Thread(char* threadName, int threadID, int initP)
 {
 	ID = threadID;
     name = threadName;
+    cpu = 0;
     stackTop = NULL;
     stack = NULL;
     status = JUST_CREATED;
@@ -46,6 +48,7 @@ Thread::Thread(char* threadName, int threadID, int initP)
 					// of machine registers
     }
     space = NULL;
+    preemptedInUserMode = FALSE;
 
     // [ADD MP3]
     priority = initP;
@@ -103,6 +106,7 @@ Thread::Fork(VoidFunctionPtr func, void *arg)
     
     DEBUG(dbgThread, "Forking thread: " << name << " f(a): " << (int) func << " " << arg);
     StackAllocate(func, arg);
+    cpu = kernel->currentCpu;		// start out on our parent's CPU
 
     oldLevel = interrupt->SetLevel(IntOff);
     scheduler->ReadyToRun(this);	// ReadyToRun assumes that interrupts 
@@ -110,6 +114,24 @@ Thread::Fork(VoidFunctionPtr func, void *arg)
     (void) interrupt->SetLevel(oldLevel);
 }    
 
+//----------------------------------------------------------------------
+// Thread::Prepare
+// 	Set the thread up to run (*func)(arg), like Fork, but without
+//	putting it on the ready queue: the caller dispatches it some
+//	other way.  Used for each CPU's idle thread (see cpu.cc), which
+//	runs only when its CPU has nothing else to do.
+//
+//	"func" is the procedure for the thread to run.
+//	"arg" is a single argument to be passed to the procedure.
+//----------------------------------------------------------------------
+
+void
+Thread::Prepare(VoidFunctionPtr func, void *arg)
+{
+    DEBUG(dbgThread, "Preparing thread: " << name);
+    StackAllocate(func, arg);
+}
+
 //----------------------------------------------------------------------
 // Thread::CheckOverflow
 // 	Check a thread's stack to see if it has overrun the space
@@ -239,7 +261,9 @@ Thread::Yield ()
 //	we have no thread to run.  "Interrupt::Idle" is called
 //	to signify that we should idle the CPU until the next I/O interrupt
 //	occurs (the only thing that could cause a thread to become
-//	ready to run).
+//	ready to run).  On a multiprocessor, the CPU's idle thread does
+//	the waiting instead (see cpu.cc), so that the other CPUs can keep
+//	running meanwhile.
 //
 //	NOTE: we assume interrupts are already disabled, because it
 //	is called from the synchronization routines which must
@@ -276,6 +300,10 @@ Thread::Sleep (bool finishing)
     status = BLOCKED;
 	//cout << "debug Thread::Sleep " << name << "wait for Idle\n";
     while ((nextThread = kernel->scheduler->FindNextToRun()) == NULL) {
+	if (kernel->numCpus > 1) {	// let this CPU's idle thread wait,
+	    nextThread = kernel->cpu[kernel->currentCpu]->idleThread;
+	    break;			// so the other CPUs can go on
+	}
 		kernel->interrupt->Idle();	// no one to run, wait for an interrupt
 	}    
     // returns when it's time for us to run
@@ -293,7 +321,7 @@ Thread::Sleep (bool finishing)
 void
 Thread::UpdateRemainBurst(){
     double newBurstTime = 0.5*T + 0.5*burstTime;
-    DEBUG(dbgQLevel, "[D] Tick [" << kernel->stats->totalTicks << "]: Thread [" << ID << "] update approximate burst time, from: [" << burstTime << "], add [" << T << "] to [" << newBurstTime << "]");
+    TRACE(kernel->stats->GlobalTicks(), TraceBurst, ID, burstTime, T, newBurstTime);
     burstTime = newBurstTime;
 }
 
@@ -305,7 +333,7 @@ Thread::UpdateRemainBurst(){
 
 void
 Thread::UpdateRunningTicks() {
-    T += kernel->stats->totalTicks - startRunningTick;
+    T += kernel->stats->GlobalTicks() - startRunningTick;
 }
 
 //----------------------------------------------------------------------
@@ -316,7 +344,7 @@ Thread::UpdateRunningTicks() {
 
 void
 Thread::UpdateWaitingTicks() {
-    W += kernel->stats->totalTicks - startWaitingTick;
+    W += kernel->stats->GlobalTicks() - startWaitingTick;
 }
 
 //----------------------------------------------------------------------
@@ -326,7 +354,7 @@ Thread::UpdateWaitingTicks() {
 //----------------------------------------------------------------------
 void
 Thread::ResetStartRunningTick() {
-    startRunningTick = kernel->stats->totalTicks;
+    startRunningTick = kernel->stats->GlobalTicks();
 }
 
 //----------------------------------------------------------------------
@@ -336,7 +364,38 @@ Thread::ResetStartRunningTick() {
 //----------------------------------------------------------------------
 void
 Thread::ResetStartWaitingTick() {
-    startWaitingTick = kernel->stats->totalTicks;
+    startWaitingTick = kernel->stats->GlobalTicks();
+}
+
+//----------------------------------------------------------------------
+// Thread::Checkpoint, Thread::Restore
+//	Save the scheduling state of the thread to the UNIX file "fd",
+//	for Kernel::Checkpoint, or load it back, for Kernel::Restore.
+//----------------------------------------------------------------------
+
+void
+Thread::Checkpoint(int fd)
+{
+    int state[6] = { priority, queueLevel, startRunningTick,
+		     startWaitingTick, T, W };
+
+    WriteFile(fd, (char *) state, sizeof(state));
+    WriteFile(fd, (char *) &burstTime, sizeof(double));
+}
+
+void
+Thread::Restore(int fd)
+{
+    int state[6];
+
+    Read(fd, (char *) state, sizeof(state));
+    Read(fd, (char *) &burstTime, sizeof(double));
+    priority = state[0];
+    queueLevel = state[1];
+    startRunningTick = state[2];
+    startWaitingTick = state[3];
+    T = state[4];
+    W = state[5];
 }
 
 //----------------------------------------------------------------------
@@ -91,6 +91,9 @@ class Thread {
 
     void Fork(VoidFunctionPtr func, void *arg); 
     				// Make thread run (*func)(arg)
+    void Prepare(VoidFunctionPtr func, void *arg);
+				// Like Fork, but leave it to the caller
+				// to dispatch the thread
     void Yield();  		// Relinquish the CPU if any 
 				// other thread is runnable
     void Sleep(bool finishing); // Put the thread to sleep and 
@@ -104,6 +107,8 @@ class Thread {
 	  char* getName() { return (name); }
     
 	  int getID() { return (ID); }
+    int getCpu() { return (cpu); }
+    void setCpu(int cpuNum) { cpu = cpuNum; }
     void Print() { cout << name; }
     void SelfTest();		// test whether thread impl is working
 
@@ -124,6 +129,9 @@ class Thread {
     void UpdatePriority() { priority = min(priority + 10, 149); }  // Update priority by 10. Called when in againg, waiting time is more than 1500 ticks
     // [END-of-ADD]
 
+    void Checkpoint(int fd);	// Save the scheduling state to the
+    void Restore(int fd);	// UNIX file "fd", or load it back
+
   private:
     // some of the private data for this class is listed above
     
@@ -133,6 +141,7 @@ class Thread {
     ThreadStatus status;	// ready, running or blocked
     char* name;
 	  int   ID;
+    int cpu;			// the CPU whose ready queues we join
     // [ADD MP3]
     int priority;     // priority (0~149)
     int queueLevel;   // queue level (1~3)
@@ -144,7 +153,7 @@ class Thread {
     // [END-of-ADD]
     void StackAllocate(VoidFunctionPtr func, void *arg);
     				// Allocate a stack for thread.
-				// Used internally by Fork()
+				// Used internally by Fork() and Prepare()
 
 // A thread running a user program actually has *two* sets of CPU registers -- 
 // one for its state while executing user code, one for its state 
@@ -157,6 +166,8 @@ class Thread {
     void RestoreUserState();		// restore user-level register state
 
     AddrSpace *space;			// User code this thread is running.
+    bool preemptedInUserMode;		// Did the thread last give up the
+					// CPU between two user instructions?
 };
 
 // external function, dummy routine whose sole job is to call Thread::Print
@@ -19,7 +19,11 @@
 #include "main.h"
 #include "addrspace.h"
 #include "machine.h"
-#include "noff.h"
+#include "swap.h"
+#include "replacement.h"
+#include "frames.h"
+#include "textcache.h"
+#include "synch.h"
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -54,6 +58,48 @@ SwapHeader(NoffHeader *noffH)
 #endif
 }
 
+//----------------------------------------------------------------------
+// InSegment
+// 	Return TRUE if part of the segment _seg_ falls in virtual page
+//	_vpn_.
+//----------------------------------------------------------------------
+
+static bool
+InSegment(Segment *seg, int vpn)
+{
+    return seg->size > 0 && seg->virtualAddr < (vpn + 1) * PageSize
+           && seg->virtualAddr + seg->size > vpn * PageSize;
+}
+
+//----------------------------------------------------------------------
+// SegmentEnd
+// 	Return the virtual address just past the segment _seg_; 0 if it
+//	is empty.
+//----------------------------------------------------------------------
+
+static unsigned int
+SegmentEnd(Segment *seg)
+{
+    return (seg->size > 0) ? seg->virtualAddr + seg->size : 0;
+}
+
+//----------------------------------------------------------------------
+// ZeroPage
+// 	Return TRUE if virtual page _vpn_ of the program _noffH_ starts
+//	out as all zeroes: nothing in it is loaded from the file, as it
+//	holds only uninitialized data, or stack.
+//----------------------------------------------------------------------
+
+static bool
+ZeroPage(NoffHeader *noffH, int vpn)
+{
+#ifdef RDATA
+    if (InSegment(&noffH->readonlyData, vpn))
+        return FALSE;
+#endif
+    return !InSegment(&noffH->code, vpn) && !InSegment(&noffH->initData, vpn);
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::AddrSpace
 // 	Create an address space to run a user program.
@@ -65,6 +111,24 @@ SwapHeader(NoffHeader *noffH)
 // [ADD] We no longer need to allocate page table here, since we should know how many page the process need
 AddrSpace::AddrSpace()
 {
+    tlbHits = tlbMisses = tlbEvictions = 0;
+    prefetches = prefetchHits = prefetchWaste = 0;
+    hitsSeen = missesSeen = evictionsSeen = 0;
+    profile = NULL;
+    pageTable = NULL;			// nothing loaded yet
+    numPages = 0;
+    zeroPages = 0;
+    heapStart = heapBreak = 0;
+    stackBottom = 0;
+    text = NULL;
+    copyOnWrite = NULL;
+    id = 0;
+    executable = NULL;
+    swapSlot = NULL;
+    prefetched = NULL;
+    for (int i = 0; i < MaxMappings; i++)
+        mappings[i].file = NULL;
+
     // pageTable = new TranslationEntry[NumPhysPages];
     // for (int i = 0; i < NumPhysPages; i++) {
     //     pageTable[i].virtualPage = i;   // for now, virt page # = phys page #
@@ -82,17 +146,54 @@ AddrSpace::AddrSpace()
 
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
-// 	Dealloate an address space.
+// 	Dealloate an address space.  With "-vm", first wait until no
+//	page of ours is being written out by another thread's fault.
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace()
 {
+    Machine *machine = kernel->machine;
+
+    kernel->stats->numZeroFramesSaved += ZeroFrames();
+    for (int i = 0; i < MaxMappings; i++)
+    {
+        if (mappings[i].file != NULL)
+            Unmap(&mappings[i]);        // write back what we changed
+    }
+    if (kernel->demandPaging)
+        kernel->pagingLock->Acquire();  // none of our pages is in transit
     // [ADD] Reset the physical page in use state
-    for(int i=0 ; i<numPages ; i++){
-        kernel->physInUse[pageTable[i].physicalPage] = FALSE;
+    for(int i=0 ; pageTable != NULL && i<numPages ; i++){
+        TranslationEntry *pte = pageTable->Find(i);
+        if (pte == NULL || !pte->valid)
+            continue;           // paged out, or never paged in
+        kernel->frames->Free(pte->physicalPage);
+        kernel->frameOwner[pte->physicalPage] = NULL;
     }
     // [END-of-ADD]
+    if (text != NULL)
+        kernel->textCache->Release(text);
+    if (swapSlot != NULL) {
+        for (unsigned int i = 0; i < numPages; i++) {
+            if (swapSlot[i] >= 0)
+                kernel->swapSpace->Free(swapSlot[i]);
+        }
+    }
+    if (kernel->currentThread->space == this) {
+        // the machine must not go on using our translations
+        for (int i = 0; machine->tlb != NULL && i < machine->tlbSize; i++)
+            machine->tlb[i].valid = FALSE;
+        machine->FlushSoftTLB();
+        machine->profile = NULL;
+    }
     delete pageTable;
+    delete [] swapSlot;
+    if (kernel->demandPaging)
+        kernel->pagingLock->Release();
+    delete [] prefetched;
+    delete [] copyOnWrite;
+    delete executable;
+    delete profile;
 }
 
 //----------------------------------------------------------------------
@@ -111,6 +212,8 @@ bool AddrSpace::Load(char *fileName)
     OpenFile *executable = kernel->fileSystem->Open(fileName);
     NoffHeader noffH;
     unsigned int size;
+    int *frames, numFrames;
+    unsigned int firstText, numText;
 
     if (executable == NULL)
     {
@@ -124,19 +227,26 @@ bool AddrSpace::Load(char *fileName)
         SwapHeader(&noffH);
     ASSERT(noffH.noffMagic == NOFFMAGIC);
 
+    // how big is address space?  The program, then room for its heap
+    // to grow into, then room for files to be mapped (see Map), then a
+    // guard page, then room for the stack to grow down into; the heap
+    // starts out empty, and its pages have no frames until it grows
+    // over them (see Sbrk), and the stack starts out as its top
+    // UserStackSize bytes (see GrowStack)
+    heapStart = max(SegmentEnd(&noffH.code), SegmentEnd(&noffH.initData));
+    heapStart = max(heapStart, SegmentEnd(&noffH.uninitData));
 #ifdef RDATA
-    // how big is address space?
-    size = noffH.code.size + noffH.readonlyData.size + noffH.initData.size +
-           noffH.uninitData.size + UserStackSize;
-    // we need to increase the size
-    // to leave room for the stack
-#else
-    // how big is address space?
-    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size + UserStackSize; // we need to increase the size
-                                                                                          // to leave room for the stack
+    heapStart = max(heapStart, SegmentEnd(&noffH.readonlyData));
 #endif
-    numPages = divRoundUp(size, PageSize);
+    heapStart = divRoundUp(heapStart, PageSize) * PageSize;
+    heapBreak = heapStart;
+    numPages = (heapStart + UserHeapSize + UserMapSize) / PageSize + 1
+               + divRoundUp(max(kernel->stackLimit, UserStackSize), PageSize);
+    stackBottom = numPages - divRoundUp(UserStackSize, PageSize);
     size = numPages * PageSize;
+    copyOnWrite = new bool[numPages];
+    for (unsigned int i = 0; i < numPages; i++)
+        copyOnWrite[i] = FALSE;
 
     // [ADD] since we have exception handler now, so we may no longer need this
     //ASSERT(numPages <= NumPhysPages); // check we're not trying
@@ -145,40 +255,100 @@ bool AddrSpace::Load(char *fileName)
                                       // virtual memory
     // [END-of-ADD]
 
+    if (kernel->demandPaging)
+    {
+        // Nothing is read in yet: each page comes into a frame when it
+        // is first touched, so we keep the file open to load it from
+        // (see PageIn)
+        pageTable = new PageTable(kernel->pageTableKind, numPages);
+        swapSlot = new int[numPages];
+        prefetched = new bool[numPages];
+        for (unsigned int i = 0; i < numPages; i++)
+        {
+            swapSlot[i] = -1;
+            prefetched[i] = FALSE;
+        }
+        this->executable = executable;
+        this->noffH = noffH;
+        DEBUG(dbgAddr, "Demand paging address space: " << numPages << ", " << size);
+        if (kernel->profiling)
+            profile = new Profile(fileName, noffH.code.virtualAddr, noffH.code.size);
+        return TRUE;
+    }
+
+    // The pages holding nothing but code may already be in memory, if
+    // another copy of the program is running (see textcache.h)
+    firstText = noffH.code.virtualAddr / PageSize;
+    numText = (noffH.code.virtualAddr % PageSize == 0) ? noffH.code.size / PageSize : 0;
+    if (numText > 0)
+        text = kernel->textCache->Find(fileName, executable->Length(), &noffH);
+
+    // With "-zf", the pages of zeroes need no frames of their own yet
+    numFrames = 0;
+    for (unsigned int j = 0; j < numPages; j++)
+    {
+        if (!InSpace(j) || (text != NULL && j >= firstText && j < firstText + numText))
+            continue;
+        if (kernel->zeroFrame >= 0 && ZeroPage(&noffH, j))
+            zeroPages++;
+        else
+            numFrames++;
+    }
+
     // [ADD] Now we know we need numPages, it's okay to allocate now.
     // But first check whether we have enough space
+    frames = new int[numFrames];
+    if (!kernel->frames->Allocate(numFrames, frames, kernel->contiguousFrames))
     {
-        int counter = 0;
-        for (int i = 0; i < NumPhysPages; i++)
+        DEBUG(dbgAddr, "We don't have enough sapce for this process. Need " << numFrames << ", but only have " << kernel->frames->NumFree());
+        delete [] frames;
+        if (text != NULL)
         {
-            if (!kernel->physInUse[i])
-                counter++;
+            kernel->textCache->Release(text);
+            text = NULL;
         }
-        if (counter < numPages)
-        {
-            DEBUG(dbgAddr, "We don't have enough sapce for this process. Need " << numPages << ", but only have " << counter);
-            // NOTE: According to the discussion, call ExceptionHandler directly is okay
-            // After all, we cannot access RaiseException directly.
+        delete executable;
+        // NOTE: According to the discussion, call ExceptionHandler directly is okay
+        // After all, we cannot access RaiseException directly.
+        // But an Exec loads the program for its parent (see
+        // Kernel::ExecChild), which just gets -1 back
+        if (kernel->currentThread->space == this)
             ExceptionHandler(MemoryLimitException);
-            return FALSE;
-        }
+        return FALSE;
     }
-    // Now we make sure the memory space is enough, allocate now
-    pageTable = new TranslationEntry[numPages];
-    for (int i = 0, j = 0 ; i < NumPhysPages && j < numPages; i++)
-    {
-        // if physical page i is okay, place it
-        if(!kernel->physInUse[i]){
-            pageTable[j].virtualPage = j;
-            pageTable[j].physicalPage = i;
-            pageTable[j].valid = TRUE;
-            pageTable[j].use = FALSE;
-            pageTable[j].dirty = FALSE;
-            pageTable[j].readOnly = FALSE;
-            kernel->physInUse[i] = TRUE;
-            // Remember to initialize the memory content to all zero
-            bzero(kernel->machine->mainMemory + pageTable[j++].physicalPage * PageSize, PageSize);
+    // Now we make sure the memory space is enough, place the pages
+    pageTable = new PageTable(kernel->pageTableKind, numPages);
+    for (unsigned int i = 0, j = 0; j < numPages; j++)
+    {
+        TranslationEntry *pte;
+
+        if (!InSpace(j))
+            continue;   // the heap (or the stack) has not grown this far
+        pte = pageTable->Entry(j);
+        pte->valid = TRUE;
+        if (text != NULL && j >= firstText && j < firstText + numText)
+        {
+            // already loaded, and maybe already decoded too
+            pte->physicalPage = text->frames[j - firstText];
+            pte->readOnly = TRUE;
+            kernel->frames->Share(pte->physicalPage);
+            continue;
+        }
+        if (zeroPages > 0 && ZeroPage(&noffH, j))
+        {
+            // the zero frame stands in for it until it is written
+            // (see CopyOnWrite)
+            pte->physicalPage = kernel->zeroFrame;
+            pte->readOnly = TRUE;
+            copyOnWrite[j] = TRUE;
+            kernel->frames->Share(kernel->zeroFrame);
+            continue;
         }
+        pte->physicalPage = frames[i];
+        // The frame may still hold decoded code of its previous owner
+        kernel->machine->InvalidateDecodedPage(frames[i]);
+        // Remember to initialize the memory content to all zero
+        bzero(kernel->machine->mainMemory + frames[i++] * PageSize, PageSize);
     }
     // [END-of-ADD]
 
@@ -215,6 +385,13 @@ bool AddrSpace::Load(char *fileName)
         int startAddr = noffH.code.virtualAddr;
         int remainingSize = noffH.code.size;
         int position = noffH.code.inFileAddr;
+        if (text != NULL)
+        {
+            // only the last page, which is not all code, is our own
+            startAddr += numText * PageSize;
+            remainingSize -= numText * PageSize;
+            position += numText * PageSize;
+        }
         while(remainingSize > 0){
             unsigned int physAddr;
             Translate(startAddr, &physAddr, 1);
@@ -278,10 +455,95 @@ bool AddrSpace::Load(char *fileName)
     }
 #endif
 
+    // The code pages are in place: from now on they are only read, so
+    // the next copy of the program can have them too.  frames[] only
+    // lists the frames in the order they were handed out, so the page
+    // table tells which one holds each code page.
+    if (text == NULL && numText > 0)
+    {
+        int *textFrames = new int[numText];
+
+        for (unsigned int j = firstText; j < firstText + numText; j++)
+        {
+            TranslationEntry *pte = pageTable->Find(j);
+
+            pte->readOnly = TRUE;
+            textFrames[j - firstText] = pte->physicalPage;
+        }
+        text = kernel->textCache->Enter(fileName, executable->Length(), &noffH,
+                                        numText, textFrames);
+        delete [] textFrames;
+    }
+    delete [] frames;
+
+    if (kernel->profiling)
+        profile = new Profile(fileName, noffH.code.virtualAddr, noffH.code.size);
+
     delete executable; // close file
     return TRUE;       // success
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::Clone
+// 	Make this address space, which has nothing loaded, a copy of
+//	"parent", the address space of the running program.
+//
+//	We don't copy any memory: both address spaces map each page to
+//	the same frame, read-only, so that the first write to a page by
+//	either one raises ReadOnlyException, and only then does the
+//	writer get its own copy (see CopyOnWrite).  Pages that are
+//	read-only anyway, like shared code, stay shared.
+//
+//	The copy resumes at the instruction where "parent" will, with
+//	the same registers, except that r2 (the return value of a system
+//	call) is 0.  It does not get the files "parent" has mapped.
+//
+//	With "-vm", a frame can only belong to one address space, so we
+//	cannot clone.
+//----------------------------------------------------------------------
+
+void AddrSpace::Clone(AddrSpace *parent)
+{
+    Machine *machine = kernel->machine;
+
+    ASSERT(!kernel->demandPaging && kernel->currentThread->space == parent);
+    parent->FlushTLB();     // its entries would still allow writes
+    numPages = parent->numPages;
+    heapStart = parent->heapStart;
+    heapBreak = parent->heapBreak;
+    stackBottom = parent->stackBottom;
+    zeroPages = parent->ZeroFrames();
+    pageTable = new PageTable(kernel->pageTableKind, numPages);
+    copyOnWrite = new bool[numPages];
+    for (unsigned int i = 0; i < numPages; i++)
+    {
+        TranslationEntry *pte = parent->pageTable->Find(i);
+
+        copyOnWrite[i] = parent->copyOnWrite[i];
+        if (pte == NULL || !pte->valid || parent->FindMapping(i) != NULL)
+            continue;
+        if (!pte->readOnly)
+        {
+            pte->readOnly = TRUE;
+            parent->copyOnWrite[i] = TRUE;
+            copyOnWrite[i] = TRUE;
+        }
+        *pageTable->Entry(i) = *pte;
+        kernel->frames->Share(pte->physicalPage);
+    }
+    machine->FlushSoftTLB();    // and so would the soft TLB's
+    if ((text = parent->text) != NULL)
+        kernel->textCache->Share(text);
+
+    for (int i = 0; i < NumTotalRegs; i++)
+        save_registers[i] = machine->ReadRegister(i);
+    save_registers[2] = 0;
+    save_PCReg = machine->ReadRegister(PCReg);
+    save_NextPCReg = machine->ReadRegister(NextPCReg);
+    save_StackReg = machine->ReadRegister(StackReg);
+    DEBUG(dbgAddr, "Clone address space: " << numPages << " pages");
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::Execute
 // 	Run a user program using the current thread
@@ -306,6 +568,84 @@ void AddrSpace::Execute(char *fileName)
                         // by doing the syscall "exit"
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::Resume
+// 	Run a user program restored from a checkpoint, using the current
+//	thread.  Like Execute, but the registers are the saved ones.
+//----------------------------------------------------------------------
+
+void AddrSpace::Resume()
+{
+    kernel->currentThread->space = this;
+
+    this->RestoreState();  // load page table register, and the registers
+
+    kernel->machine->Run(); // go on with the user progam
+
+    ASSERTNOTREACHED();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Checkpoint
+// 	Save what we need to resume this address space to the UNIX file
+//	"fd": the page table (and which pages are copy-on-write), where
+//	the heap and the stack end, and the user registers, as of the
+//	last SaveState.  Physical memory is saved by Kernel::Checkpoint.
+//	Mapped files are not saved, any more than open files are.
+//----------------------------------------------------------------------
+
+void AddrSpace::Checkpoint(int fd)
+{
+    TranslationEntry none;  // for pages with no entry
+
+    bzero((char *) &none, sizeof(none));
+    WriteFile(fd, (char *) &numPages, sizeof(numPages));
+    for (unsigned int i = 0; i < numPages; i++)
+    {
+        TranslationEntry *pte = pageTable->Find(i);
+        WriteFile(fd, (char *) (pte != NULL ? pte : &none), sizeof(TranslationEntry));
+    }
+    WriteFile(fd, (char *) copyOnWrite, numPages * sizeof(bool));
+    WriteFile(fd, (char *) &zeroPages, sizeof(int));
+    WriteFile(fd, (char *) &heapStart, sizeof(int));
+    WriteFile(fd, (char *) &heapBreak, sizeof(int));
+    WriteFile(fd, (char *) &stackBottom, sizeof(int));
+    WriteFile(fd, (char *) save_registers, sizeof(save_registers));
+    WriteFile(fd, (char *) &save_PCReg, sizeof(int));
+    WriteFile(fd, (char *) &save_NextPCReg, sizeof(int));
+    WriteFile(fd, (char *) &save_StackReg, sizeof(int));
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Restore
+// 	Load back an address space saved by Checkpoint from the UNIX file
+//	"fd", instead of loading a program.
+//----------------------------------------------------------------------
+
+void AddrSpace::Restore(int fd)
+{
+    TranslationEntry pte;
+
+    Read(fd, (char *) &numPages, sizeof(numPages));
+    pageTable = new PageTable(kernel->pageTableKind, numPages);
+    for (unsigned int i = 0; i < numPages; i++)
+    {
+        Read(fd, (char *) &pte, sizeof(TranslationEntry));
+        if (pte.valid)
+            *pageTable->Entry(i) = pte;
+    }
+    copyOnWrite = new bool[numPages];
+    Read(fd, (char *) copyOnWrite, numPages * sizeof(bool));
+    Read(fd, (char *) &zeroPages, sizeof(int));
+    Read(fd, (char *) &heapStart, sizeof(int));
+    Read(fd, (char *) &heapBreak, sizeof(int));
+    Read(fd, (char *) &stackBottom, sizeof(int));
+    Read(fd, (char *) save_registers, sizeof(save_registers));
+    Read(fd, (char *) &save_PCReg, sizeof(int));
+    Read(fd, (char *) &save_NextPCReg, sizeof(int));
+    Read(fd, (char *) &save_StackReg, sizeof(int));
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::InitRegisters
 // 	Set the initial values for the user-level register set.
@@ -352,9 +692,13 @@ void AddrSpace::InitRegisters()
 //	to this address space, that needs saving.
 //
 //	For now, don't need to save anything!
+//
+//	"keepTLB" is set when the thread is only leaving the Machine to
+//	another simulated CPU, and will be back on this CPU, with its
+//	own TLB (see Scheduler::SwitchCpu).
 //----------------------------------------------------------------------
 
-void AddrSpace::SaveState()
+void AddrSpace::SaveState(bool keepTLB)
 {
     // [ADD] for saving current registers
     Machine *machine = kernel->machine;
@@ -365,6 +709,35 @@ void AddrSpace::SaveState()
     save_NextPCReg = machine->ReadRegister(NextPCReg);
     save_StackReg = machine->ReadRegister(StackReg);
     // [END-of-ADD]
+
+    // The TLB holds translations for this address space only: save the
+    // use and dirty bits it collected, and empty it for the next one.
+    if (machine->tlb != NULL) {
+        if (!keepTLB)
+            FlushTLB();
+        ChargeTLB();
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::FlushTLB
+// 	Copy the use and dirty bits the TLB collected for this (running)
+//	address space into the page table, and invalidate its entries,
+//	so that they are refilled from the page table when used again.
+//----------------------------------------------------------------------
+
+void AddrSpace::FlushTLB()
+{
+    Machine *machine = kernel->machine;
+
+    for (int i = 0; machine->tlb != NULL && i < machine->tlbSize; i++) {
+        if (machine->tlb[i].valid) {
+            TranslationEntry *pte = pageTable->Find(machine->tlb[i].virtualPage);
+            pte->use = machine->tlb[i].use;
+            pte->dirty |= machine->tlb[i].dirty;
+            machine->tlb[i].valid = FALSE;
+        }
+    }
 }
 
 //----------------------------------------------------------------------
@@ -379,8 +752,17 @@ void AddrSpace::RestoreState()
 {
     // [ADD] also restore register state
     Machine *machine = kernel->machine;
-    machine->pageTable = pageTable;
+    if (machine->tlb == NULL) {
+        machine->pageTable = pageTable;
+    } else {
+        machine->pageTable = NULL;   // translate through the TLB only
+        hitsSeen = kernel->stats->numTLBHits;
+        missesSeen = kernel->stats->numTLBMisses;
+        evictionsSeen = kernel->stats->numTLBEvictions;
+    }
     machine->pageTableSize = numPages;
+    machine->profile = profile;
+    machine->FlushSoftTLB();	// its translations were for the old table
 
     for (int i = 0; i < NumTotalRegs; i++){
         machine->WriteRegister(i, save_registers[i]);
@@ -412,7 +794,12 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
         return AddressErrorException;
     }
 
-    pte = &pageTable[vpn];
+    pte = pageTable->Find(vpn);
+
+    if (pte == NULL || !pte->valid)
+    {
+        return PageFaultException;
+    }
 
     if (isReadWrite && pte->readOnly)
     {
@@ -445,3 +832,842 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
 
     return NoException;
 }
+
+//----------------------------------------------------------------------
+// AddrSpace::TranslateIn
+//  Like Translate, but first bring the page in, if it is not in
+//  memory yet, or copy it, if it is written and copy-on-write.  For
+//  the kernel's own accesses to user memory.
+//----------------------------------------------------------------------
+ExceptionType
+AddrSpace::TranslateIn(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
+{
+    ExceptionType result = Translate(vaddr, paddr, isReadWrite);
+
+    if (result == PageFaultException && PageIn(vaddr))
+        result = Translate(vaddr, paddr, isReadWrite);
+    if (result == ReadOnlyException && CopyOnWrite(vaddr))
+        result = Translate(vaddr, paddr, isReadWrite);
+    return result;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyUser
+//  Copy _size_ bytes between the virtual address _vaddr_ and the
+//  kernel buffer _buf_: into user memory if _toUser_, out of it
+//  otherwise.  Within a page, user memory is one contiguous span of
+//  physical memory, wherever its frame is, so we move it with one
+//  bcopy per page.  Like a store, a copy into a page that has been
+//  executed drops its predecoded instructions.
+//  Return _size_, or -1 if part of the range does not translate (in
+//  which case the pages before it may have been copied).
+//----------------------------------------------------------------------
+
+int
+AddrSpace::CopyUser(unsigned int vaddr, char *buf, int size, bool toUser)
+{
+    char *mainMemory = kernel->machine->mainMemory;
+    unsigned int paddr;
+    int done, span;
+
+    for (done = 0; done < size; done += span) {
+        if (TranslateIn(vaddr + done, &paddr, toUser) != NoException)
+            return -1;
+        span = min(size - done, (int) (PageSize - paddr % PageSize));
+        if (toUser)
+        {
+            // as in Machine::WriteMem: the page may have been executed
+            kernel->machine->InvalidateDecodedPage(paddr / PageSize);
+            bcopy(buf + done, &mainMemory[paddr], span);
+        }
+        else
+            bcopy(&mainMemory[paddr], buf + done, span);
+    }
+    return size;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyFromUser, AddrSpace::CopyToUser
+//  Copy _size_ bytes at the virtual address _vaddr_ into the kernel
+//  buffer _buf_, or the other way.  See CopyUser.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::CopyFromUser(unsigned int vaddr, char *buf, int size)
+{
+    return CopyUser(vaddr, buf, size, FALSE);
+}
+
+int
+AddrSpace::CopyToUser(unsigned int vaddr, char *buf, int size)
+{
+    return CopyUser(vaddr, buf, size, TRUE);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyStringFromUser
+//  Copy the '\0'-terminated string at the virtual address _vaddr_
+//  into the kernel buffer _buf_, of _maxSize_ bytes, a page at a time.
+//  Return the length of the string, or -1 if it does not translate,
+//  or does not fit.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::CopyStringFromUser(unsigned int vaddr, char *buf, int maxSize)
+{
+    char *mainMemory = kernel->machine->mainMemory;
+    char *end;
+    unsigned int paddr;
+    int done, span;
+
+    for (done = 0; done < maxSize; done += span) {
+        if (TranslateIn(vaddr + done, &paddr, FALSE) != NoException)
+            return -1;
+        span = min(maxSize - done, (int) (PageSize - paddr % PageSize));
+        end = (char *) memchr(&mainMemory[paddr], '\0', span);
+        if (end != NULL) {
+            span = end - &mainMemory[paddr];
+            bcopy(&mainMemory[paddr], buf + done, span + 1);
+            return done + span;
+        }
+        bcopy(&mainMemory[paddr], buf + done, span);
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// LoadSegment
+//  Copy the part of the segment _seg_ of _executable_ that falls in
+//  virtual page _vpn_ into _into_, the frame the page goes in.
+//----------------------------------------------------------------------
+
+static void
+LoadSegment(OpenFile *executable, Segment *seg, int vpn, char *into)
+{
+    int start = max(seg->virtualAddr, vpn * PageSize);
+    int end = min(seg->virtualAddr + seg->size, (vpn + 1) * PageSize);
+
+    if (start < end)
+        executable->ReadAt(into + start - vpn * PageSize, end - start,
+                           seg->inFileAddr + start - seg->virtualAddr);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::LoadPage
+//  Fill the frame _into_ with virtual page _vpn_ as the program file
+//  has it: whatever parts of the code and data segments are in the
+//  page, and zeroes everywhere else (uninitialized data and stack).
+//  A page of a mapped file comes from that file instead.
+//----------------------------------------------------------------------
+void
+AddrSpace::LoadPage(int vpn, char *into)
+{
+    Mapping *mapping = FindMapping(vpn);
+
+    if (mapping != NULL)
+    {
+        MapIO(mapping, vpn, into, FALSE);
+        return;
+    }
+    DEBUG(dbgAddr, "Load page " << vpn << " from the program file");
+    bzero(into, PageSize);
+    LoadSegment(executable, &noffH.code, vpn, into);
+    LoadSegment(executable, &noffH.initData, vpn, into);
+#ifdef RDATA
+    LoadSegment(executable, &noffH.readonlyData, vpn, into);
+#endif
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PageIn
+//  Handle a page fault on the virtual address _vaddr_, with "-vm":
+//  find a frame for its page, paging another page out if memory is
+//  full, and fill it from swap space if the page was written out
+//  there, or else from the program file.  The calling thread waits
+//  for whatever disk I/O this takes.
+//
+//  The frame to page out is chosen by the replacement policy (see
+//  replacement.h).  While a frame is being written out or filled,
+//  it has no owner, so that no one else picks it; and we
+//  hold the paging lock throughout, so that no one faults a page
+//  back in from swap space before we are done writing it there.
+//
+//  Without "-vm", the only pages not in memory are those of the heap,
+//  and of the stack below its first pages, which get a frame of
+//  zeroes when they are first touched, and those of mapped files,
+//  which are read from the file.
+//
+//  A fault below the stack makes it grow (see GrowStack).
+//
+//  With "-cluster", the pages after the one faulted on come in with
+//  it, as many as Cluster says, each into a frame found the same
+//  way.  The frames are all found first, so that the pages are then
+//  read from swap space one after another, on consecutive sectors:
+//  after the first, each is in the disk's track buffer.
+//
+//  Return FALSE if _vaddr_ is not in this address space (or past the
+//  end of the heap or the stack), or if there is no frame for a page
+//  of zeroes.
+//----------------------------------------------------------------------
+bool
+AddrSpace::PageIn(unsigned int vaddr)
+{
+    unsigned int vpn = vaddr / PageSize;
+    TranslationEntry *pte;
+    int frame, cluster;
+    int frames[MaxClusterPages];
+
+    if (vpn >= numPages || (!InSpace(vpn) && !GrowStack(vpn)))
+    {
+        return FALSE;
+    }
+    if (!kernel->demandPaging)
+    {
+        pte = pageTable->Find(vpn);
+        if (pte != NULL && pte->valid)
+            return FALSE;
+        if ((frame = kernel->frames->Allocate()) < 0)
+        {
+            cerr << "Out of memory for page " << vpn << "\n";
+            return FALSE;
+        }
+        kernel->stats->numPageFaults++;
+        DEBUG(dbgAddr, "Page " << vpn << " gets frame " << frame);
+        if (FindMapping(vpn) != NULL)
+            MapIO(FindMapping(vpn), vpn, &kernel->machine->mainMemory[frame * PageSize], FALSE);
+        else
+            bzero(&kernel->machine->mainMemory[frame * PageSize], PageSize);
+        // The frame may still hold decoded code of its previous owner
+        kernel->machine->InvalidateDecodedPage(frame);
+        pte = pageTable->Entry(vpn);
+        pte->physicalPage = frame;
+        pte->valid = TRUE;
+        pte->use = FALSE;
+        pte->dirty = FALSE;
+        pte->readOnly = FALSE;
+        return TRUE;
+    }
+    kernel->stats->numPageFaults++;
+    kernel->pagingLock->Acquire();
+
+    cluster = Cluster(vpn);
+    for (int i = 0; i < cluster; i++)
+    {
+        if ((frame = kernel->frames->Allocate()) < 0)
+        {
+            frame = kernel->replacement->Victim();
+            DEBUG(dbgAddr, "Page out frame " << frame << " for page " << vpn + i);
+            kernel->frameOwner[frame]->PageOut(kernel->frameVpn[frame]);
+        }
+        frames[i] = frame;
+    }
+
+    for (int i = 0; i < cluster; i++, vpn++)
+    {
+        frame = frames[i];
+        if (swapSlot[vpn] >= 0)
+        {
+            DEBUG(dbgAddr, "Load page " << vpn << " from swap slot " << swapSlot[vpn]);
+            kernel->swapSpace->ReadPage(swapSlot[vpn],
+                                        &kernel->machine->mainMemory[frame * PageSize]);
+        }
+        else
+        {
+            LoadPage(vpn, &kernel->machine->mainMemory[frame * PageSize]);
+        }
+        // The frame may still hold decoded code of its previous page
+        kernel->machine->InvalidateDecodedPage(frame);
+
+        pte = pageTable->Entry(vpn);
+        pte->physicalPage = frame;
+        pte->valid = TRUE;
+        pte->use = FALSE;
+        pte->dirty = FALSE;             // the same as its copy outside
+        prefetched[vpn] = (i > 0);
+        kernel->frameOwner[frame] = this;
+        kernel->frameVpn[frame] = vpn;
+        kernel->replacement->Loaded(frame);
+    }
+    prefetches += cluster - 1;
+    kernel->pagingLock->Release();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Cluster
+//  Return how many pages to bring in on a fault on page _vpn_: just
+//  it, unless "-cluster" asks for more, and it is in swap space.
+//  Then the pages after it in the address space go too, as long as
+//  they are not in memory and are in the slots right after it.
+//
+//  Pages that come from the program file, or from a mapped file,
+//  come in one at a time: they are not on the simulated disk, so
+//  reading them early saves no disk time, and the first time they
+//  are touched is often the only time.
+//----------------------------------------------------------------------
+int
+AddrSpace::Cluster(unsigned int vpn)
+{
+    TranslationEntry *pte;
+    int n;
+
+    if (swapSlot[vpn] < 0)
+        return 1;
+    for (n = 1; n < kernel->clusterPages && vpn + n < numPages; n++)
+    {
+        pte = pageTable->Find(vpn + n);
+        if ((pte != NULL && pte->valid)
+              || swapSlot[vpn + n] != swapSlot[vpn] + n)
+            break;
+    }
+    return n;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PageOut
+//  Take page _vpn_ out of its frame, to give the frame to another
+//  page; the frame has no owner until the caller fills it.  If the
+//  page was written to since it came in, write it to swap space
+//  first, and wait for the disk; or back to its file, if it is a
+//  page of a mapped file.
+//----------------------------------------------------------------------
+void
+AddrSpace::PageOut(int vpn)
+{
+    Machine *machine = kernel->machine;
+    TranslationEntry *pte = pageTable->Find(vpn);
+    Mapping *mapping = FindMapping(vpn);
+    int frame = pte->physicalPage;
+    bool dirty;
+
+    if (kernel->currentThread->space == this)
+    {
+        // the TLB may know the page is dirty; the page table may not
+        for (int i = 0; machine->tlb != NULL && i < machine->tlbSize; i++)
+        {
+            if (machine->tlb[i].valid && machine->tlb[i].virtualPage == vpn)
+            {
+                pte->dirty |= machine->tlb[i].dirty;
+                machine->tlb[i].valid = FALSE;
+            }
+        }
+        machine->FlushSoftTLB();
+    }
+    SettlePrefetch(vpn, pte->use);
+    dirty = pte->dirty;
+    kernel->frameOwner[frame] = NULL;
+    pageTable->Remove(vpn);             // before we wait for the disk
+
+    if (dirty && mapping != NULL)
+    {
+        MapIO(mapping, vpn, &machine->mainMemory[frame * PageSize], TRUE);
+    }
+    else if (dirty)
+    {
+        // with "-cluster", keep the pages of a run on consecutive
+        // slots if we can, so that they come back in together
+        if (swapSlot[vpn] < 0 && kernel->clusterPages > 1 && vpn > 0
+              && swapSlot[vpn - 1] >= 0)
+            swapSlot[vpn] = kernel->swapSpace->Allocate(swapSlot[vpn - 1] + 1);
+        if (swapSlot[vpn] < 0)
+            swapSlot[vpn] = kernel->swapSpace->Allocate();
+        if (swapSlot[vpn] < 0)
+        {
+            cerr << "Out of swap space\n";
+            Abort();
+        }
+        DEBUG(dbgAddr, "Write page " << vpn << " to swap slot " << swapSlot[vpn]);
+        kernel->swapSpace->WritePage(swapSlot[vpn], &machine->mainMemory[frame * PageSize]);
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyOnWrite
+//  Handle a write to the read-only page holding _vaddr_: if it is
+//  only read-only because it is shared with a clone, copy it into a
+//  frame of our own (unless no one else has it any more), and let us
+//  write to it.  Our translation of the page, in the TLB or the soft
+//  TLB, is out of date, so it goes.
+//
+//  A page still mapped to the zero frame (see Load) is shared the
+//  same way, with the kernel keeping the zero frame for good; its
+//  new frame only needs to be cleared.
+//
+//  Return FALSE if the page is really read-only, or if memory is
+//  full.
+//----------------------------------------------------------------------
+bool
+AddrSpace::CopyOnWrite(unsigned int vaddr)
+{
+    Machine *machine = kernel->machine;
+    unsigned int vpn = vaddr / PageSize;
+    TranslationEntry *pte;
+    int frame;
+
+    if (vpn >= numPages || (pte = pageTable->Find(vpn)) == NULL
+        || !pte->valid || !copyOnWrite[vpn])
+    {
+        return FALSE;
+    }
+    frame = pte->physicalPage;
+    if (kernel->frames->NumRefs(frame) > 1)
+    {
+        if ((frame = kernel->frames->Allocate()) < 0)
+        {
+            cerr << "Out of memory to copy a page\n";
+            return FALSE;
+        }
+        DEBUG(dbgAddr, "Copy page " << vpn << " from frame " << pte->physicalPage << " to " << frame);
+        if (pte->physicalPage == kernel->zeroFrame)
+        {
+            bzero(&machine->mainMemory[frame * PageSize], PageSize);
+            kernel->stats->numZeroFills++;
+        }
+        else
+            bcopy(&machine->mainMemory[pte->physicalPage * PageSize],
+                  &machine->mainMemory[frame * PageSize], PageSize);
+        // The frame may still hold decoded code of its previous owner
+        machine->InvalidateDecodedPage(frame);
+        kernel->frames->Free(pte->physicalPage);
+        pte->physicalPage = frame;
+    }
+    pte->readOnly = FALSE;
+    copyOnWrite[vpn] = FALSE;
+
+    for (int i = 0; machine->tlb != NULL && i < machine->tlbSize; i++)
+    {
+        if (machine->tlb[i].valid && machine->tlb[i].virtualPage == (int) vpn)
+        {
+            pte->use = machine->tlb[i].use;
+            machine->tlb[i].valid = FALSE;
+        }
+    }
+    machine->FlushSoftTLB();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Sbrk
+//  Move the end of the heap by _increment_ bytes, and return where it
+//  was; or -1 if that would take it below its start, or more than
+//  UserHeapSize past it.
+//
+//  The pages the heap grows over get no frames yet: each one gets a
+//  frame of zeroes when it is first touched (see PageIn), or with
+//  "-zf" is mapped to the zero frame until it is written.  The pages
+//  it shrinks off are given up at once, frames and swap space; they
+//  are zeroes again if it grows back over them.
+//----------------------------------------------------------------------
+int
+AddrSpace::Sbrk(int increment)
+{
+    unsigned int oldBreak = heapBreak;
+
+    if (increment > (int) (heapStart + UserHeapSize - heapBreak)
+        || increment < -(int) (heapBreak - heapStart))
+    {
+        return -1;
+    }
+    heapBreak += increment;
+    DEBUG(dbgAddr, "Heap end moves from " << oldBreak << " to " << heapBreak);
+
+    if (kernel->demandPaging)
+        kernel->pagingLock->Acquire();  // none of its pages is in transit
+    for (unsigned int vpn = divRoundUp(heapBreak, PageSize);
+         vpn < divRoundUp(oldBreak, PageSize); vpn++)
+    {
+        FreePage(vpn);
+    }
+    if (kernel->demandPaging)
+        kernel->pagingLock->Release();
+
+    for (unsigned int vpn = divRoundUp(oldBreak, PageSize);
+         kernel->zeroFrame >= 0 && vpn < divRoundUp(heapBreak, PageSize); vpn++)
+    {
+        TranslationEntry *pte = pageTable->Entry(vpn);
+
+        pte->physicalPage = kernel->zeroFrame;
+        pte->valid = TRUE;
+        pte->readOnly = TRUE;
+        copyOnWrite[vpn] = TRUE;
+        kernel->frames->Share(kernel->zeroFrame);
+        zeroPages++;
+    }
+    kernel->machine->FlushSoftTLB();
+    return oldBreak;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::FreePage
+//  Give up the frame of page _vpn_, if it has one, and its swap
+//  space, if any, as the heap shrinks off it, or as it is unmapped.
+//----------------------------------------------------------------------
+void
+AddrSpace::FreePage(int vpn)
+{
+    Machine *machine = kernel->machine;
+    TranslationEntry *pte = pageTable->Find(vpn);
+
+    if (pte != NULL && pte->valid)
+    {
+        for (int i = 0; machine->tlb != NULL && i < machine->tlbSize; i++)
+        {
+            if (machine->tlb[i].valid && machine->tlb[i].virtualPage == vpn)
+            {
+                pte->use |= machine->tlb[i].use;
+                machine->tlb[i].valid = FALSE;
+            }
+        }
+        SettlePrefetch(vpn, pte->use);
+        kernel->frames->Free(pte->physicalPage);
+        kernel->frameOwner[pte->physicalPage] = NULL;
+    }
+    if (pte != NULL)
+    {
+        pte->readOnly = FALSE;
+        pageTable->Remove(vpn);
+    }
+    if (swapSlot != NULL && swapSlot[vpn] >= 0)
+    {
+        kernel->swapSpace->Free(swapSlot[vpn]);
+        swapSlot[vpn] = -1;
+    }
+    copyOnWrite[vpn] = FALSE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::GrowStack
+//  Handle a fault on page _vpn_, below the first page of the stack:
+//  the stack grows down to it.  The pages in between are now in the
+//  address space too, but like _vpn_ they get no frames until they
+//  are touched (see PageIn).
+//
+//  The stack may grow up to the guard page just above the room for
+//  mapped files, which is never in the address space: a program that
+//  faults on it has overflowed its stack (of "-stack" bytes).
+//  Return FALSE if _vpn_ is not where the stack can grow.
+//----------------------------------------------------------------------
+bool
+AddrSpace::GrowStack(unsigned int vpn)
+{
+    unsigned int guard = (heapStart + UserHeapSize + UserMapSize) / PageSize;
+
+    if (vpn == guard)
+    {
+        cerr << "Stack overflow, at page " << vpn << "\n";
+        return FALSE;
+    }
+    if (vpn < guard || vpn >= stackBottom)
+    {
+        return FALSE;
+    }
+    DEBUG(dbgAddr, "Stack grows from page " << stackBottom << " down to " << vpn);
+    stackBottom = vpn;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::InSpace
+//  Return TRUE unless page _vpn_ lies past the end of the heap, or
+//  of the stack, in the room they have left to grow into, or in the
+//  room for mapped files, outside them.
+//----------------------------------------------------------------------
+bool
+AddrSpace::InSpace(unsigned int vpn)
+{
+    return vpn < divRoundUp(heapBreak, PageSize) || vpn >= stackBottom
+           || FindMapping(vpn) != NULL;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Map
+//  Map the first _length_ bytes of _file_ into this address space,
+//  at the lowest run of pages free for it in the room for mapped
+//  files, and return the address it starts at; or -1 if there is no
+//  room, or we already have MaxMappings files mapped.  The mapping
+//  takes _file_ over, and deletes it when it goes.
+//
+//  None of its pages are read yet: each one is read from the file
+//  when it is first touched (see PageIn), and if it is written to,
+//  written back to the file when it is paged out, or when the file
+//  is unmapped or the program exits.
+//----------------------------------------------------------------------
+int
+AddrSpace::Map(OpenFile *file, int length)
+{
+    unsigned int first = (heapStart + UserHeapSize) / PageSize;
+    unsigned int start = first;
+    unsigned int n = divRoundUp(length, PageSize);
+    Mapping *mapping = NULL;
+
+    if (length <= 0 || n > UserMapSize / PageSize)
+    {
+        return -1;
+    }
+    for (int i = 0; i < MaxMappings; i++)
+    {
+        if (mappings[i].file == NULL)
+            mapping = &mappings[i];
+        else if (mappings[i].start < start + n
+                 && mappings[i].start + mappings[i].numPages > start)
+        {
+            start = mappings[i].start + mappings[i].numPages;
+            i = -1;     // overlaps: try past it, against them all again
+            mapping = NULL;
+        }
+    }
+    if (mapping == NULL || start + n > first + UserMapSize / PageSize)
+    {
+        return -1;
+    }
+    mapping->file = file;
+    mapping->start = start;
+    mapping->numPages = n;
+    mapping->length = length;
+    DEBUG(dbgAddr, "Map " << length << " bytes at page " << start);
+    return start * PageSize;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Unmap
+//  Drop the mapping that starts at _vaddr_, writing the pages of it
+//  that were written to back to the file.  Return 0, or -1 if no
+//  mapping starts there.
+//----------------------------------------------------------------------
+int
+AddrSpace::Unmap(unsigned int vaddr)
+{
+    for (int i = 0; i < MaxMappings; i++)
+    {
+        if (mappings[i].file != NULL && mappings[i].start * PageSize == vaddr)
+        {
+            Unmap(&mappings[i]);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Unmap
+//  Drop _mapping_: write each page of it that was written to back to
+//  the file, give up its frames, and close the file.
+//----------------------------------------------------------------------
+void
+AddrSpace::Unmap(Mapping *mapping)
+{
+    Machine *machine = kernel->machine;
+
+    DEBUG(dbgAddr, "Unmap " << mapping->length << " bytes at page " << mapping->start);
+    if (kernel->currentThread->space == this)
+        FlushTLB();     // the TLB may know a page is dirty
+    if (kernel->demandPaging)
+        kernel->pagingLock->Acquire();  // none of its pages is in transit
+    for (unsigned int vpn = mapping->start;
+         vpn < mapping->start + mapping->numPages; vpn++)
+    {
+        TranslationEntry *pte = pageTable->Find(vpn);
+
+        if (pte != NULL && pte->valid && pte->dirty)
+            MapIO(mapping, vpn, &machine->mainMemory[pte->physicalPage * PageSize], TRUE);
+        FreePage(vpn);
+    }
+    if (kernel->demandPaging)
+        kernel->pagingLock->Release();
+    delete mapping->file;
+    mapping->file = NULL;
+    machine->FlushSoftTLB();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::FindMapping
+//  Return the mapping page _vpn_ is in, or NULL if it is not in one.
+//----------------------------------------------------------------------
+Mapping *
+AddrSpace::FindMapping(unsigned int vpn)
+{
+    for (int i = 0; i < MaxMappings; i++)
+    {
+        if (mappings[i].file != NULL && vpn >= mappings[i].start
+            && vpn < mappings[i].start + mappings[i].numPages)
+            return &mappings[i];
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::MapIO
+//  Read page _vpn_ of _mapping_ from its file into _frame_, with
+//  zeroes past the end of the mapping (or of the file); or, if
+//  _writing_, write it from _frame_ back to the file.
+//----------------------------------------------------------------------
+void
+AddrSpace::MapIO(Mapping *mapping, int vpn, char *frame, bool writing)
+{
+    int offset = (vpn - mapping->start) * PageSize;
+    int size = min(PageSize, mapping->length - offset);
+
+    if (writing)
+    {
+        DEBUG(dbgAddr, "Write page " << vpn << " back to its file, at " << offset);
+        mapping->file->WriteAt(frame, size, offset);
+    }
+    else
+    {
+        DEBUG(dbgAddr, "Read page " << vpn << " from its file, at " << offset);
+        bzero(frame, PageSize);
+        mapping->file->ReadAt(frame, size, offset);
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::LoadTLB
+//  Handle a TLB miss on the virtual address _vaddr_: copy its page
+//  table entry into the TLB entry the machine picks, after saving the
+//  use and dirty bits of the translation being evicted, and charge
+//  the time the refill takes.
+//  Return FALSE if _vaddr_ is not in this address space.
+//----------------------------------------------------------------------
+bool
+AddrSpace::LoadTLB(unsigned int vaddr)
+{
+    Machine *machine = kernel->machine;
+    unsigned int vpn = vaddr / PageSize;
+    TranslationEntry *pte, *victim;
+
+    if (vpn >= numPages || (pte = pageTable->Walk(vpn)) == NULL || !pte->valid)
+    {
+        return FALSE;
+    }
+
+    victim = &machine->tlb[machine->TLBReplace(vpn)];
+    if (victim->valid)
+    {
+        DEBUG(dbgAddr, "Evict TLB entry for page " << victim->virtualPage);
+        TranslationEntry *evicted = pageTable->Find(victim->virtualPage);
+        evicted->use = victim->use;
+        evicted->dirty |= victim->dirty;
+        kernel->stats->numTLBEvictions++;
+    }
+    *victim = *pte;
+    DEBUG(dbgAddr, "Load TLB entry for page " << vpn);
+
+    kernel->stats->totalTicks += TLBMissTicks;
+    kernel->stats->systemTicks += TLBMissTicks;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ChargeTLB
+//  Add the TLB hits, misses and evictions since the last call (or
+//  since we were last switched in) to this address space's counters.
+//----------------------------------------------------------------------
+void
+AddrSpace::ChargeTLB()
+{
+    Statistics *stats = kernel->stats;
+
+    tlbHits += stats->numTLBHits - hitsSeen;
+    tlbMisses += stats->numTLBMisses - missesSeen;
+    tlbEvictions += stats->numTLBEvictions - evictionsSeen;
+    hitsSeen = stats->numTLBHits;
+    missesSeen = stats->numTLBMisses;
+    evictionsSeen = stats->numTLBEvictions;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PrintTLBStats
+//  Print the TLB counters of this address space, for the process
+//  _name_; called when it exits.
+//----------------------------------------------------------------------
+void
+AddrSpace::PrintTLBStats(char *name)
+{
+    ChargeTLB();
+    cout << "TLB, " << name << ": hits " << tlbHits << ", misses "
+         << tlbMisses << ", evictions " << tlbEvictions << "\n";
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ZeroFrames
+//  Return how many of our pages are still mapped to the zero frame:
+//  the frames "-zf" saves us, as things are now.
+//----------------------------------------------------------------------
+int
+AddrSpace::ZeroFrames()
+{
+    int n = 0;
+
+    for (unsigned int i = 0; kernel->zeroFrame >= 0 && i < numPages; i++)
+    {
+        TranslationEntry *pte = pageTable->Find(i);
+        if (pte != NULL && pte->valid && pte->physicalPage == kernel->zeroFrame)
+            n++;
+    }
+    return n;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PrintZeroFillStats
+//  Print how many pages of this address space started out as zeroes
+//  (or still were, when it was cloned), and how many never had to
+//  be given a frame, for the process _name_; called when it exits.
+//----------------------------------------------------------------------
+void
+AddrSpace::PrintZeroFillStats(char *name)
+{
+    cout << "Zero fill, " << name << ": pages " << zeroPages
+         << ", frames saved " << ZeroFrames() << "\n";
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::SettlePrefetch
+//  If page _vpn_ came in ahead of a fault, and we did not know yet
+//  whether that paid off, count it as a hit if it was _used_ (before
+//  going, or before the replacement policy clears its use bit), and
+//  as waste if not.
+//----------------------------------------------------------------------
+void
+AddrSpace::SettlePrefetch(int vpn, bool used)
+{
+    if (prefetched == NULL || !prefetched[vpn])
+        return;
+    prefetched[vpn] = FALSE;
+    if (used)
+        prefetchHits++;
+    else
+        prefetchWaste++;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PrintPrefetchStats
+//  Print how many pages "-cluster" brought into this address space
+//  ahead of a fault, and how many of them were used, for the process
+//  _name_; called when it exits.  The pages still in memory count
+//  by their use bits as things are now.
+//----------------------------------------------------------------------
+void
+AddrSpace::PrintPrefetchStats(char *name)
+{
+    if (kernel->currentThread->space == this)
+        FlushTLB();
+    for (unsigned int i = 0; prefetched != NULL && i < numPages; i++)
+    {
+        TranslationEntry *pte = pageTable->Find(i);
+        SettlePrefetch(i, pte != NULL && pte->use);
+    }
+    cout << "Prefetch, " << name << ": pages " << prefetches << ", hits "
+         << prefetchHits << ", waste " << prefetchWaste << "\n";
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ReportProfile
+//  Print where this address space spent its time, if we are
+//  profiling; called when it exits.
+//----------------------------------------------------------------------
+void
+AddrSpace::ReportProfile()
+{
+    if (profile != NULL)
+        profile->Report(id);
+}
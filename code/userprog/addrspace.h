@@ -15,8 +15,39 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "profile.h"
+#include "noff.h"
 
-#define UserStackSize		1024 	// increase this as necessary!
+class TextImage;
+
+// A file mapped into an address space: pages of the mapping are read
+// from the file when they are touched, and written back to it when
+// they go, if they were written to
+
+class Mapping {
+  public:
+    OpenFile *file;			// our own handle on the file, which
+					// stays open after Close; NULL if
+					// this mapping is not in use
+    unsigned int start;			// its first page
+    unsigned int numPages;
+    int length;				// # of bytes of the file mapped
+};
+
+#define UserStackSize		1024 	// the stack a program starts with;
+					// it grows as need be, up to
+#define UserStackLimit		8192	// this many bytes, by default (see
+					// AddrSpace::GrowStack)
+#define UserHeapSize		16384	// the most a program's heap can
+					// grow to (see AddrSpace::Sbrk)
+#define UserMapSize		32768	// room for the files a program maps
+#define MaxMappings		4	// into memory, and how many it may
+					// map at once (see AddrSpace::Map)
+#define MaxClusterPages		8	// the most pages "-cluster" may bring
+					// in on one page fault
+#define UserStringSize		256	// longest string (with its '\0')
+					// a system call takes from a user
+					// program
 
 class AddrSpace {
   public:
@@ -30,23 +61,144 @@ class AddrSpace {
     void Execute(char *fileName);             	// Run a program
 					// assumes the program has already
                                         // been loaded
+    void Resume();			// Go on running a program restored
+					// from a checkpoint
+
+    void Clone(AddrSpace *parent);	// Make this a copy of "parent",
+					// sharing its pages until one of
+					// the two writes to them; it
+					// resumes where "parent" is now
+
+    bool IsLoaded() { return (pageTable != NULL); }
+    int GetId() { return id; }		// Which process this is (see
+    void SetId(int id) { this->id = id; } // process.h)
+    void Checkpoint(int fd);		// Save the page table and registers
+    void Restore(int fd);		// to the UNIX file "fd", or load
+					// them back
 
-    void SaveState();			// Save/restore address space-specific
-    void RestoreState();		// info on a context switch 
+    void SaveState(bool keepTLB = FALSE);
+					// Save/restore address space-specific
+    void RestoreState();		// info on a context switch; keep
+					// the TLB if we only switch CPUs
 
     // Translate virtual address _vaddr_
     // to physical address _paddr_. _mode_
     // is 0 for Read, 1 for Write.
     ExceptionType Translate(unsigned int vaddr, unsigned int *paddr, int mode);
 
+    // Copy between user virtual addresses and kernel buffers, a page
+    // at a time; these return -1 if an address is not in this space
+    int CopyFromUser(unsigned int vaddr, char *buf, int size);
+    int CopyToUser(unsigned int vaddr, char *buf, int size);
+    int CopyStringFromUser(unsigned int vaddr, char *buf, int maxSize);
+					// returns the length of the string;
+					// -1 if it is longer than maxSize - 1
+
+    bool PageIn(unsigned int vaddr);	// Bring the page holding _vaddr_
+					// into a frame, with "-vm"; FALSE
+					// if it is not in this address space
+    void PageOut(int vpn);		// Give up the frame of page _vpn_,
+					// writing it to swap if it is dirty
+    int Sbrk(int increment);		// Grow (or shrink) the heap by
+					// _increment_ bytes; return its
+					// old end, or -1 if it cannot
+    int Map(OpenFile *file, int length); // Map the first _length_ bytes
+					// of _file_; return where, or -1
+    int Unmap(unsigned int vaddr);	// Write back and drop the mapping
+					// at _vaddr_; -1 if there is none
+    bool CopyOnWrite(unsigned int vaddr); // Give the page holding _vaddr_
+					// a frame of our own, after a
+					// write to it; FALSE if it is not
+					// a copy-on-write page
+    TranslationEntry *PageEntry(int vpn) { return pageTable->Entry(vpn); }
+					// for the page replacement policy
+    void SettlePrefetch(int vpn, bool used); // If page _vpn_ was
+					// prefetched, count it as a hit if
+					// it was _used_, else as waste
+
+    bool LoadTLB(unsigned int vaddr);	// Refill the TLB after a miss on
+					// _vaddr_; FALSE if it is not in
+					// this address space
+    void FlushTLB();			// Write the TLB's use and dirty
+					// bits back, and empty it
+    void PrintTLBStats(char *name);	// Print this process's TLB counters
+    void PrintZeroFillStats(char *name); // and how many frames "-zf"
+					// saved it
+    void PrintPrefetchStats(char *name); // and how its prefetches did
+    void ReportProfile();		// Print this process's profile, if
+					// we are profiling
+
+    int tlbHits, tlbMisses, tlbEvictions; // TLB activity while this
+					// address space was running
+    int prefetches, prefetchHits, prefetchWaste; // pages "-cluster"
+					// brought in ahead of a fault, and
+					// how many were used before they
+					// went, or not
+
   private:
-    TranslationEntry *pageTable;	// Assume linear page table translation
-					// for now!
+    PageTable *pageTable;		// where our pages are, in the shape
+					// "-pt" asks for (see pagetable.h)
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
+    Profile *profile;			// where the instructions we execute
+					// are counted; NULL if not profiling
+    OpenFile *executable;		// with "-vm", the program file, and
+    NoffHeader noffH;			// where its segments are, to load
+					// pages from
+    int *swapSlot;			// with "-vm", where each page is in
+					// swap space; -1 if it is not
+    bool *prefetched;			// with "-vm", which pages came in
+					// ahead of a fault, and are not
+					// known to be used yet
+    TextImage *text;			// our code, if it may be shared
+					// with other copies of the program
+    bool *copyOnWrite;			// which pages are read-only only
+					// because they are shared with a
+					// clone (see Clone)
+    int id;				// our process id
+    int zeroPages;			// # of pages mapped to the zero
+					// frame at first (see Load)
+    unsigned int heapStart;		// the heap: from the end of the
+    unsigned int heapBreak;		// program, up to heapBreak; the
+					// pages after it up to the stack
+					// are not in the address space
+    unsigned int stackBottom;		// the first page of the stack; it
+					// grows down to the guard page
+    Mapping mappings[MaxMappings];	// the files mapped between the heap
+					// and the stack
 
     void InitRegisters();		// Initialize user-level CPU registers,
 					// before jumping to user code
+    int CopyUser(unsigned int vaddr, char *buf, int size, bool toUser);
+					// CopyFromUser and CopyToUser
+    ExceptionType TranslateIn(unsigned int vaddr, unsigned int *paddr,
+			      int isReadWrite);
+					// Translate, paging in if need be
+    void LoadPage(int vpn, char *into);	// Read page _vpn_ of the program
+					// file into a frame
+    int Cluster(unsigned int vpn);	// # of pages to bring in on a
+					// fault on page _vpn_, from it on
+    void FreePage(int vpn);		// Give up page _vpn_ of the heap,
+					// or of a mapping
+    Mapping *FindMapping(unsigned int vpn); // The mapping page _vpn_ is
+					// in; NULL if none
+    void Unmap(Mapping *mapping);	// Write back and drop _mapping_
+    void MapIO(Mapping *mapping, int vpn, char *frame, bool writing);
+					// Read page _vpn_ of _mapping_ into
+					// _frame_, or write it back
+    bool GrowStack(unsigned int vpn);	// Grow the stack down to page _vpn_
+    bool InSpace(unsigned int vpn);	// Is page _vpn_ not past the end
+					// of the heap or the stack, nor
+					// in the room for mappings, unless
+					// a file is mapped there?
+
+    int ZeroFrames();			// # of pages still mapped to the
+					// zero frame
+
+    void ChargeTLB();			// Add the TLB activity since the
+					// last call to our counters
+    int hitsSeen, missesSeen, evictionsSeen; // the global TLB counters
+					// at the last call to ChargeTLB
     
     // [ADD] For restore state
     int save_registers[NumTotalRegs];
@@ -58,10 +58,13 @@ void ExceptionHandler(ExceptionType which)
 	switch (which)
 	{
 	case SyscallException:
+		if (kernel->HoldSyscall())	// a checkpoint is due
+			return;
 		switch (type)
 		{
 		case SC_Halt:
 			DEBUG(dbgSys, "Shutdown, initiated by user program.\n");
+			kernel->currentThread->space->ReportProfile();
 			SysHalt();
 			cout << "in exception\n";
 			ASSERTNOTREACHED();
@@ -83,18 +86,23 @@ void ExceptionHandler(ExceptionType which)
 			DEBUG(dbgSys, "Message received.\n");
 			val = kernel->machine->ReadRegister(4);
 			{
-				char *msg = &(kernel->machine->mainMemory[val]);
-				cout << msg << endl;
+				char msg[UserStringSize];
+				if (kernel->currentThread->space->CopyStringFromUser(val, msg, UserStringSize) >= 0)
+					cout << msg << endl;
 			}
+			kernel->currentThread->space->ReportProfile();
 			SysHalt();
 			ASSERTNOTREACHED();
 			break;
 		case SC_Create:
 			val = kernel->machine->ReadRegister(4);
 			{
-				char *filename = &(kernel->machine->mainMemory[val]);
+				char filename[UserStringSize];
 				// cout << filename << endl;
-				status = SysCreate(filename);
+				if (kernel->currentThread->space->CopyStringFromUser(val, filename, UserStringSize) < 0)
+					status = 0;
+				else
+					status = SysCreate(filename);
 				kernel->machine->WriteRegister(2, (int)status);
 			}
 			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
@@ -131,9 +139,12 @@ void ExceptionHandler(ExceptionType which)
 			DEBUG(dbgAddr, "Open\n");
 			{
 				val = kernel->machine->ReadRegister(4);
-				char *filename = &(kernel->machine->mainMemory[val]);
+				char filename[UserStringSize];
 				DEBUG(dbgTraCode, "In ExceptionHandler(), into SysOpen, " << kernel->stats->totalTicks);
-				status = SysOpen(filename);
+				if (kernel->currentThread->space->CopyStringFromUser(val, filename, UserStringSize) < 0)
+					status = -1;
+				else
+					status = SysOpen(filename);
 				DEBUG(dbgTraCode, "In ExceptionHandler(), return from SysOpen, " << kernel->stats->totalTicks);
 				kernel->machine->WriteRegister(2, (int)status);
 			}
@@ -150,9 +161,13 @@ void ExceptionHandler(ExceptionType which)
 				val = kernel->machine->ReadRegister(4);
 				numChar = kernel->machine->ReadRegister(5);
 				fileID = kernel->machine->ReadRegister(6);
-				char *buffer = &(kernel->machine->mainMemory[val]);
+				char *buffer = new char[max(numChar, 0) + 1];
 				DEBUG(dbgTraCode, "In ExceptionHandler(), into SysWrite, " << kernel->stats->totalTicks);
-				status = SysWrite(buffer, numChar, fileID);
+				if (numChar < 0 || kernel->currentThread->space->CopyFromUser(val, buffer, numChar) < 0)
+					status = -1;
+				else
+					status = SysWrite(buffer, numChar, fileID);
+				delete [] buffer;
 				DEBUG(dbgTraCode, "In ExceptionHandler(), return from SysWrite, " << kernel->stats->totalTicks);
 				kernel->machine->WriteRegister(2, (int)status);
 			}
@@ -169,9 +184,15 @@ void ExceptionHandler(ExceptionType which)
 				val = kernel->machine->ReadRegister(4);
 				numChar = kernel->machine->ReadRegister(5);
 				fileID = kernel->machine->ReadRegister(6);
-				char *buffer = &(kernel->machine->mainMemory[val]);
+				char *buffer = new char[max(numChar, 0) + 1];
 				DEBUG(dbgTraCode, "In ExceptionHandler(), into SysRead, " << kernel->stats->totalTicks);
-				status = SysRead(buffer, numChar, fileID);
+				if (numChar < 0)
+					status = -1;
+				else
+					status = SysRead(buffer, numChar, fileID);
+				if (status > 0 && kernel->currentThread->space->CopyToUser(val, buffer, status) < 0)
+					status = -1;
+				delete [] buffer;
 				DEBUG(dbgTraCode, "In ExceptionHandler(), return from SysRead, " << kernel->stats->totalTicks);
 				kernel->machine->WriteRegister(2, (int)status);
 			}
@@ -202,13 +223,109 @@ void ExceptionHandler(ExceptionType which)
 			DEBUG(dbgAddr, "Program exit\n");
 			val = kernel->machine->ReadRegister(4);
 			cout << "return value:" << val << endl;
+			if (kernel->machine->tlb != NULL)
+				kernel->currentThread->space->PrintTLBStats(kernel->currentThread->getName());
+			if (kernel->zeroFrame >= 0)
+				kernel->currentThread->space->PrintZeroFillStats(kernel->currentThread->getName());
+			if (kernel->demandPaging && kernel->clusterPages > 1)
+				kernel->currentThread->space->PrintPrefetchStats(kernel->currentThread->getName());
+			kernel->currentThread->space->ReportProfile();
+			SysExit(val);
+			// its frames (and swap space) go to the others
+			delete kernel->currentThread->space;
+			kernel->currentThread->space = NULL;
 			kernel->currentThread->Finish();
 			break;
+		case SC_Exec:
+			DEBUG(dbgSys, "Exec\n");
+			val = kernel->machine->ReadRegister(4);
+			{
+				char filename[UserStringSize];
+				if (kernel->currentThread->space->CopyStringFromUser(val, filename, UserStringSize) < 0)
+					status = -1;
+				else
+					status = SysExec(filename);
+				kernel->machine->WriteRegister(2, (int)status);
+			}
+			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			return;
+			ASSERTNOTREACHED();
+			break;
+		case SC_Fork:
+			DEBUG(dbgSys, "Fork\n");
+			// The clone goes on after the call, like us
+			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			status = SysFork();
+			kernel->machine->WriteRegister(2, (int)status);
+			return;
+			ASSERTNOTREACHED();
+			break;
+		case SC_Join:
+			DEBUG(dbgSys, "Join " << kernel->machine->ReadRegister(4) << "\n");
+			status = SysJoin(kernel->machine->ReadRegister(4));
+			kernel->machine->WriteRegister(2, (int)status);
+			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			return;
+			ASSERTNOTREACHED();
+			break;
+		case SC_Sbrk:
+			DEBUG(dbgSys, "Sbrk " << kernel->machine->ReadRegister(4) << "\n");
+			status = SysSbrk(kernel->machine->ReadRegister(4));
+			kernel->machine->WriteRegister(2, (int)status);
+			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			return;
+			ASSERTNOTREACHED();
+			break;
+		case SC_Map:
+			DEBUG(dbgSys, "Map " << kernel->machine->ReadRegister(4) << ", " << kernel->machine->ReadRegister(5) << "\n");
+			status = SysMap(kernel->machine->ReadRegister(4), kernel->machine->ReadRegister(5));
+			kernel->machine->WriteRegister(2, (int)status);
+			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			return;
+			ASSERTNOTREACHED();
+			break;
+		case SC_Unmap:
+			DEBUG(dbgSys, "Unmap " << kernel->machine->ReadRegister(4) << "\n");
+			status = SysUnmap(kernel->machine->ReadRegister(4));
+			kernel->machine->WriteRegister(2, (int)status);
+			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			return;
+			ASSERTNOTREACHED();
+			break;
 		default:
 			cerr << "Unexpected system call " << type << "\n";
 			break;
 		}
 		break;
+	case PageFaultException:
+		// With a TLB, this is a TLB miss: the page may well be in memory
+		val = kernel->machine->ReadRegister(BadVAddrReg);
+		if (kernel->machine->tlb != NULL && kernel->currentThread->space->LoadTLB(val))
+			return;		// retry the instruction that missed
+		// With "-vm", it may not have been paged in yet
+		if (kernel->currentThread->space->PageIn(val))
+			return;		// retry the instruction that faulted
+		// otherwise, fall through
+		cerr << "Unexpected user mode exception " << (int)which << "\n";
+		break;
+	case ReadOnlyException:
+		// The page may be shared with a clone until written to
+		val = kernel->machine->ReadRegister(BadVAddrReg);
+		if (kernel->currentThread->space->CopyOnWrite(val))
+			return;		// retry the instruction that wrote
+		// otherwise, fall through
 	default:
 		cerr << "Unexpected user mode exception " << (int)which << "\n";
 		break;
@@ -0,0 +1,181 @@
+// frames.cc
+//	Routines to allocate physical page frames.  See frames.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "frames.h"
+#include "debug.h"
+#include "sysdep.h"
+
+// all the bits of a word of the bitmap that stand for frames
+#define WordFull(w)	((w) == numWords - 1 && numBits % BitsInWord != 0 \
+			    ? (1U << (numBits % BitsInWord)) - 1 : ~0U)
+
+//----------------------------------------------------------------------
+// FrameAllocator::FrameAllocator
+// 	Initialize the allocator, with every frame free.
+//
+//	"numFrames" is the number of physical page frames.
+//----------------------------------------------------------------------
+
+FrameAllocator::FrameAllocator(int numFrames) : Bitmap(numFrames)
+{
+    numFree = numFrames;
+    firstWord = 0;
+    refs = new int[numFrames];
+    for (int i = 0; i < numFrames; i++)
+	refs[i] = 0;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::~FrameAllocator
+//----------------------------------------------------------------------
+
+FrameAllocator::~FrameAllocator()
+{
+    delete [] refs;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Allocate
+// 	Return the lowest numbered free frame, and mark it in use.
+//	Return -1 if all the frames are in use.
+//----------------------------------------------------------------------
+
+int
+FrameAllocator::Allocate()
+{
+    int frame;
+
+    if (numFree == 0)
+	return -1;
+    while (map[firstWord] == WordFull(firstWord))
+	firstWord++;		// there is a free frame, so this stops
+    // the lowest clear bit of that word
+    frame = firstWord * BitsInWord + __builtin_ctz(~map[firstWord]);
+    Mark(frame);
+    refs[frame] = 1;
+    numFree--;
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Allocate
+// 	Mark "n" free frames in use at once, and store their numbers in
+//	"frames".  If "contiguous", take the lowest run of "n" free frames
+//	if there is one; otherwise (or if there is none), the lowest "n"
+//	free frames.
+//
+//	Return FALSE, without allocating anything, if fewer than "n"
+//	frames are free.
+//----------------------------------------------------------------------
+
+bool
+FrameAllocator::Allocate(int n, int *frames, bool contiguous)
+{
+    int first;
+
+    if (n > numFree)
+	return FALSE;
+    if (contiguous && (first = FindRun(n)) >= 0) {
+	for (int i = 0; i < n; i++) {
+	    frames[i] = first + i;
+	    Mark(first + i);
+	    refs[first + i] = 1;
+	}
+	numFree -= n;
+	return TRUE;
+    }
+    for (int i = 0; i < n; i++)
+	frames[i] = Allocate();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::FindRun
+// 	Return the lowest numbered frame that starts a run of "n" free
+//	frames, or -1 if there is none.  Words with every frame in use
+//	are skipped whole.
+//----------------------------------------------------------------------
+
+int
+FrameAllocator::FindRun(int n)
+{
+    int first = -1, length = 0;
+
+    for (int i = firstWord * BitsInWord; i < numBits; i++) {
+	if (i % BitsInWord == 0 && map[i / BitsInWord] == WordFull(i / BitsInWord)) {
+	    length = 0;
+	    i += BitsInWord - 1;
+	    continue;
+	}
+	if (Test(i)) {
+	    length = 0;
+	    continue;
+	}
+	if (length++ == 0)
+	    first = i;
+	if (length == n)
+	    return first;
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Share
+// 	Note that one more address space has "frame", which is in use.
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::Share(int frame)
+{
+    ASSERT(Test(frame));
+    refs[frame]++;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Free
+// 	Drop a reference to "frame"; if it was the last one, mark the
+//	frame free again.
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::Free(int frame)
+{
+    ASSERT(Test(frame) && refs[frame] > 0);
+    if (--refs[frame] > 0)
+	return;
+    Clear(frame);
+    numFree++;
+    if (frame / BitsInWord < firstWord)
+	firstWord = frame / BitsInWord;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Checkpoint, FrameAllocator::Restore
+// 	Save the references to each frame to the checkpoint file "fd",
+//	or read them back, and work out again which frames are free.
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::Checkpoint(int fd)
+{
+    WriteFile(fd, (char *) refs, numBits * sizeof(int));
+}
+
+void
+FrameAllocator::Restore(int fd)
+{
+    Read(fd, (char *) refs, numBits * sizeof(int));
+    for (int i = 0; i < numBits; i++) {
+	if (refs[i] > 0)
+	    Mark(i);
+	else
+	    Clear(i);
+    }
+    numFree = NumClear();
+    firstWord = 0;
+}
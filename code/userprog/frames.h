@@ -0,0 +1,62 @@
+// frames.h
+//	Data structures to keep track of which physical page frames
+//	are free.
+//
+//	A frame allocator is a bitmap (see bitmap.h) with a count of the
+//	free frames, so that asking how many there are does not take a
+//	pass over memory.  To find a free frame, it skips a whole word
+//	of frames in use at a time, starting at the lowest word that may
+//	have one, and then finds the first clear bit of the word in one
+//	step; so frames are still handed out lowest first.  Only with
+//	"-contig" does a program get a run of frames instead.
+//
+//	A frame can be in more than one address space at once (the code
+//	of a program several copies of which are running, see
+//	textcache.h).  Each one that has it holds a reference, and the
+//	frame is free again when the last one lets go.  Clones (see
+//	AddrSpace::Clone) share all their frames the same way, until
+//	they write to them.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FRAMES_H
+#define FRAMES_H
+
+#include "copyright.h"
+#include "bitmap.h"
+
+class FrameAllocator : public Bitmap {
+  public:
+    FrameAllocator(int numFrames);	// All frames are free
+    ~FrameAllocator();
+
+    int Allocate();			// Find the lowest free frame, now
+					// in use; -1 if there are none
+    bool Allocate(int n, int *frames, bool contiguous);
+					// Find "n" free frames at once; if
+					// "contiguous", a run of them if
+					// there is one.  FALSE (and none
+					// allocated) if there are not "n"
+    void Share(int frame);		// One more reference to a frame
+					// in use
+    void Free(int frame);		// Drop a reference to a frame;
+					// the last one gives it back
+    int NumFree() const { return numFree; }
+    int NumRefs(int frame) const { return refs[frame]; }
+
+    void Checkpoint(int fd);		// Save or restore the references
+    void Restore(int fd);		// to each frame
+
+  private:
+    int numFree;			// # of clear bits
+    int *refs;				// per frame: # of references to it
+    int firstWord;			// no word before this one has a
+					// clear bit
+
+    int FindRun(int n);			// the first of the lowest run of
+					// "n" free frames; -1 if none
+};
+
+#endif // FRAMES_H
@@ -14,6 +14,7 @@
 #include "kernel.h"
 
 #include "synchconsole.h"
+#include "process.h"
 
 
 void SysHalt()
@@ -62,4 +63,46 @@ int SysClose(OpenFileId id)
   return kernel->fileSystem->CloseFile(id);
 }
 
+SpaceId SysExec(char *name)
+{
+  return kernel->ExecChild(name);
+}
+
+SpaceId SysFork()
+{
+  return kernel->ForkChild();
+}
+
+int SysSbrk(int increment)
+{
+  return kernel->currentThread->space->Sbrk(increment);
+}
+
+int SysMap(OpenFileId id, int length)
+{
+  OpenFile *file = kernel->fileSystem->MapFile(id);
+  int addr;
+
+  if (file == NULL)
+    return -1;
+  if ((addr = kernel->currentThread->space->Map(file, length)) < 0)
+    delete file;
+  return addr;
+}
+
+int SysUnmap(int addr)
+{
+  return kernel->currentThread->space->Unmap(addr);
+}
+
+int SysJoin(SpaceId id)
+{
+  return kernel->processes->Join(id, kernel->currentThread->space->GetId());
+}
+
+void SysExit(int status)
+{
+  kernel->processes->Exit(kernel->currentThread->space->GetId(), status);
+}
+
 #endif /* ! __USERPROG_KSYSCALL_H__ */
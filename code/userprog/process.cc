@@ -0,0 +1,164 @@
+// process.cc
+//	Routines to keep track of the user programs that are running.
+//	See process.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "process.h"
+#include "synch.h"
+#include "sysdep.h"
+
+//----------------------------------------------------------------------
+// ProcessTable::ProcessTable
+// 	Initialize an empty process table.
+//----------------------------------------------------------------------
+
+ProcessTable::ProcessTable()
+{
+    for (int i = 0; i < MaxProcesses; i++)
+	table[i].id = 0;
+    nextId = 1;
+    joining = 0;
+    lock = new Lock("process table");
+    exited = new Condition("process exited");
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::~ProcessTable
+//----------------------------------------------------------------------
+
+ProcessTable::~ProcessTable()
+{
+    delete exited;
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Find
+// 	Return the entry of process "id", or NULL if it is not in the
+//	table.
+//----------------------------------------------------------------------
+
+Process *
+ProcessTable::Find(int id)
+{
+    for (int i = 0; id > 0 && i < MaxProcesses; i++) {
+	if (table[i].id == id)
+	    return &table[i];
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Add
+// 	Enter a new process that has just been started by "parent" (0 if
+//	none), and return its id.  Return -1 if there is no room.
+//----------------------------------------------------------------------
+
+int
+ProcessTable::Add(int parent)
+{
+    Process *process = NULL;
+
+    for (int i = 0; process == NULL && i < MaxProcesses; i++) {
+	if (table[i].id == 0)
+	    process = &table[i];
+    }
+    if (process == NULL)
+	return -1;
+    process->id = nextId++;
+    process->parent = parent;
+    process->exited = FALSE;
+    process->status = 0;
+    return process->id;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Exit
+// 	Process "id" called Exit with "status": keep the status for its
+//	parent, and wake it up if it is waiting in Join.  If there is no
+//	parent to join it, the entry is free at once.
+//
+//	Its own children will not be joined now: those that are done
+//	leave the table, and the others when they are.
+//
+//	Like Add, this runs without giving up the CPU, so only waking
+//	the parent needs the lock; a program with no parent exits with
+//	no more ticks than it did before there were processes.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Exit(int id, int status)
+{
+    Process *process;
+
+    if ((process = Find(id)) == NULL)
+	return;
+    for (int i = 0; i < MaxProcesses; i++) {
+	if (table[i].id == 0 || table[i].parent != id)
+	    continue;
+	if (table[i].exited)
+	    table[i].id = 0;
+	else
+	    table[i].parent = 0;
+    }
+    if (process->parent == 0) {
+	process->id = 0;
+	return;
+    }
+    lock->Acquire();
+    process->exited = TRUE;
+    process->status = status;
+    exited->Broadcast(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Join
+// 	Wait until process "id", a child of "parent", has exited, and
+//	return its status; the entry is then free.  Return -1 if there
+//	is no such child (or it was already joined).
+//----------------------------------------------------------------------
+
+int
+ProcessTable::Join(int id, int parent)
+{
+    Process *process;
+    int status = -1;
+
+    lock->Acquire();
+    process = Find(id);
+    if (process != NULL && process->parent == parent) {
+	joining++;
+	while (!process->exited)
+	    exited->Wait(lock);
+	joining--;
+	status = process->status;
+	process->id = 0;
+    }
+    lock->Release();
+    return status;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Checkpoint, ProcessTable::Restore
+// 	Save the table to the checkpoint file "fd", or read it back.  No
+//	one is waiting in Join when a checkpoint is taken.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Checkpoint(int fd)
+{
+    WriteFile(fd, (char *) &nextId, sizeof(int));
+    WriteFile(fd, (char *) table, sizeof(table));
+}
+
+void
+ProcessTable::Restore(int fd)
+{
+    Read(fd, (char *) &nextId, sizeof(int));
+    Read(fd, (char *) table, sizeof(table));
+}
@@ -0,0 +1,69 @@
+// process.h
+//	Data structures to keep track of the user programs that are
+//	running, so that one can wait for another to finish.
+//
+//	Each address space is a process, with an id that is never used
+//	again.  The programs started with "-e" have no parent; those
+//	started by the Exec and Fork system calls are children of the
+//	program that made the call, which can Join them to get the
+//	status they passed to Exit.
+//
+//	A process that exits stays in the table until its parent joins
+//	it, or exits too; a child still running when its parent exits
+//	is forgotten as soon as it is done.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROCESS_H
+#define PROCESS_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Lock;
+class Condition;
+
+const int MaxProcesses = 64;		// # of processes, running or
+					// waiting to be joined, at once
+
+// An entry of the process table; "id" is 0 if the entry is free
+class Process {
+  public:
+    int id;				// 1, 2, ...
+    int parent;				// id of the process that started
+					// this one; 0 if none
+    bool exited;			// has it called Exit?
+    int status;				// and if so, with what
+};
+
+class ProcessTable {
+  public:
+    ProcessTable();			// No processes yet
+    ~ProcessTable();
+
+    int Add(int parent);		// Enter a new process, child of
+					// "parent"; return its id, or -1
+					// if the table is full
+    void Exit(int id, int status);	// Process "id" is done
+    int Join(int id, int parent);	// Wait for the child "id" of
+					// "parent" to exit; return its
+					// status, or -1 if it is not one
+    int NumJoining() { return joining; } // # of threads waiting in Join
+
+    void Checkpoint(int fd);		// Save or restore the table to
+    void Restore(int fd);		// the UNIX file "fd"
+
+  private:
+    Process table[MaxProcesses];
+    int nextId;				// the id of the next process
+    int joining;			// # of threads waiting in Join
+    Lock *lock;				// for Join to wait on "exited"
+    Condition *exited;			// some process exited
+
+    Process *Find(int id);		// the entry of process "id"; NULL
+					// if there is none
+};
+
+#endif // PROCESS_H
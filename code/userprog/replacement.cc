@@ -0,0 +1,292 @@
+// replacement.cc
+//	Routines to choose which page to page out.  See replacement.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "replacement.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// Replacement::Replacement
+// 	Initialize the bookkeeping of a page replacement policy.
+//
+//	"policy" -- how Victim picks the frame to page out
+//----------------------------------------------------------------------
+
+Replacement::Replacement(ReplacementPolicy policy)
+{
+    this->policy = policy;
+    hand = 0;
+    loads = 0;
+    for (int i = 0; i < NumPhysPages; i++) {
+	loadedAt[i] = 0;
+	age[i] = 0;
+	lastUsed[i] = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// Replacement::Entry
+// 	Return the page table entry of the page in "frame", or NULL if
+//	the frame is free or in transit.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+Replacement::Entry(int frame)
+{
+    if (kernel->frameOwner[frame] == NULL)
+	return NULL;
+    return kernel->frameOwner[frame]->PageEntry(kernel->frameVpn[frame]);
+}
+
+//----------------------------------------------------------------------
+// Replacement::Loaded
+// 	Note that a page was just brought into "frame".  It is about to
+//	be used, so it starts out at the top of the aging order, and in
+//	the working set.
+//----------------------------------------------------------------------
+
+void
+Replacement::Loaded(int frame)
+{
+    loadedAt[frame] = loads++;
+    age[frame] = 0x80000000;
+    lastUsed[frame] = kernel->stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// Replacement::Sample
+// 	Called at each timer interrupt: shift each page's use bit into
+//	its aging counter, and clear it, so that the next interrupt sees
+//	only the references made in between.  Only the aging policy
+//	needs this.
+//----------------------------------------------------------------------
+
+void
+Replacement::Sample()
+{
+    TranslationEntry *entry;
+
+    if (policy != ReplaceAging)
+	return;
+    if (kernel->currentThread->space != NULL)
+	kernel->currentThread->space->FlushTLB();
+    SettleUses();
+    for (int i = 0; i < NumPhysPages; i++) {
+	if ((entry = Entry(i)) == NULL)
+	    continue;
+	age[i] = (age[i] >> 1) | (entry->use ? 0x80000000 : 0);
+	entry->use = FALSE;
+    }
+    kernel->machine->FlushSoftTLB();	// it would skip setting use bits
+}
+
+//----------------------------------------------------------------------
+// Replacement::Victim
+// 	Pick the frame whose page is paged out to make room for another
+//	one, by the policy.  Memory is full, so there is at least one
+//	frame with a page in it.
+//
+//	The policies look at (and clear) the use bits, so first get the
+//	running program's bits out of the TLB, and afterwards make sure
+//	the soft TLB does not let references go by without setting the
+//	bits again.
+//----------------------------------------------------------------------
+
+int
+Replacement::Victim()
+{
+    int victim;
+
+    if (kernel->currentThread->space != NULL)
+	kernel->currentThread->space->FlushTLB();
+    SettleUses();
+    switch (policy) {
+      case ReplaceClock:
+	victim = ClockVictim();
+	break;
+      case ReplaceEnhancedClock:
+	victim = EnhancedClockVictim();
+	break;
+      case ReplaceAging:
+	victim = AgingVictim();
+	break;
+      case ReplaceWSClock:
+	victim = WSClockVictim();
+	break;
+      default:
+	victim = Oldest();
+	break;
+    }
+    kernel->machine->FlushSoftTLB();
+    ASSERT(Entry(victim) != NULL);
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// Replacement::SettleUses
+// 	With "-cluster", before the policies clear the use bits, let the
+//	owner of each page used since they last did count it as a hit,
+//	if the page was prefetched (see AddrSpace::SettlePrefetch).
+//----------------------------------------------------------------------
+
+void
+Replacement::SettleUses()
+{
+    TranslationEntry *entry;
+
+    if (kernel->clusterPages <= 1)
+	return;
+    for (int i = 0; i < NumPhysPages; i++) {
+	if ((entry = Entry(i)) != NULL && entry->use)
+	    kernel->frameOwner[i]->SettlePrefetch(kernel->frameVpn[i], TRUE);
+    }
+}
+
+//----------------------------------------------------------------------
+// Replacement::Oldest
+// 	FIFO: the frame whose page was brought in first.
+//----------------------------------------------------------------------
+
+int
+Replacement::Oldest()
+{
+    int victim = -1;
+
+    for (int i = 0; i < NumPhysPages; i++) {
+	if (Entry(i) != NULL
+	      && (victim < 0 || loadedAt[i] < loadedAt[victim]))
+	    victim = i;
+    }
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// Replacement::ClockVictim
+// 	Second chance: move the hand on to the first page whose use bit
+//	is clear, clearing the bits of the pages it passes.  After one
+//	sweep, every bit is clear.
+//----------------------------------------------------------------------
+
+int
+Replacement::ClockVictim()
+{
+    TranslationEntry *entry;
+    int frame;
+
+    for (;;) {
+	frame = hand;
+	hand = (hand + 1) % NumPhysPages;
+	if ((entry = Entry(frame)) == NULL)
+	    continue;
+	if (!entry->use)
+	    return frame;
+	entry->use = FALSE;		// give it a second chance
+    }
+}
+
+//----------------------------------------------------------------------
+// Replacement::EnhancedClockVictim
+// 	Enhanced clock: look for a page neither used nor dirty, without
+//	changing anything; failing that, for one that is not used but
+//	dirty, clearing the use bits on the way.  If that fails too, all
+//	the use bits are now clear, so the next round finds one.
+//----------------------------------------------------------------------
+
+int
+Replacement::EnhancedClockVictim()
+{
+    TranslationEntry *entry;
+    int frame;
+
+    for (;;) {
+	for (int i = 0; i < NumPhysPages; i++) {
+	    frame = (hand + i) % NumPhysPages;
+	    entry = Entry(frame);
+	    if (entry != NULL && !entry->use && !entry->dirty) {
+		hand = (frame + 1) % NumPhysPages;
+		return frame;
+	    }
+	}
+	for (int i = 0; i < NumPhysPages; i++) {
+	    frame = (hand + i) % NumPhysPages;
+	    if ((entry = Entry(frame)) == NULL)
+		continue;
+	    if (!entry->use) {
+		hand = (frame + 1) % NumPhysPages;
+		return frame;
+	    }
+	    entry->use = FALSE;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// Replacement::AgingVictim
+// 	Approximate LRU: the frame with the lowest aging counter, folding
+//	in the references since the last timer interrupt; of equals, the
+//	one brought in first.
+//----------------------------------------------------------------------
+
+int
+Replacement::AgingVictim()
+{
+    TranslationEntry *entry;
+    unsigned int count, lowest = 0;
+    int victim = -1;
+
+    for (int i = 0; i < NumPhysPages; i++) {
+	if ((entry = Entry(i)) == NULL)
+	    continue;
+	count = (age[i] >> 1) | (entry->use ? 0x80000000 : 0);
+	if (victim < 0 || count < lowest
+	      || (count == lowest && loadedAt[i] < loadedAt[victim])) {
+	    victim = i;
+	    lowest = count;
+	}
+    }
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// Replacement::WSClockVictim
+// 	WSClock: move the hand on, noting the time at each page whose use
+//	bit is set (and clearing it), until it comes to a clean page that
+//	has been out of the working set for WorkingSetWindow ticks.
+//
+//	If there is none after two sweeps (by which time every use bit
+//	has been seen), take the first dirty page that is out of the
+//	working set, or else the page used longest ago.
+//----------------------------------------------------------------------
+
+int
+Replacement::WSClockVictim()
+{
+    TranslationEntry *entry;
+    int now = kernel->stats->totalTicks;
+    int frame, dirty = -1, oldest = -1;
+
+    for (int i = 0; i < 2 * NumPhysPages; i++) {
+	frame = hand;
+	hand = (hand + 1) % NumPhysPages;
+	if ((entry = Entry(frame)) == NULL)
+	    continue;
+	if (entry->use) {
+	    entry->use = FALSE;
+	    lastUsed[frame] = now;
+	    continue;
+	}
+	if (now - lastUsed[frame] > WorkingSetWindow) {
+	    if (!entry->dirty)
+		return frame;
+	    if (dirty < 0)
+		dirty = frame;
+	}
+	if (oldest < 0 || lastUsed[frame] < lastUsed[oldest])
+	    oldest = frame;
+    }
+    return (dirty >= 0) ? dirty : oldest;
+}
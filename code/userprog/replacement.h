@@ -0,0 +1,82 @@
+// replacement.h
+//	Data structures to choose which page to page out, when a page
+//	fault finds physical memory full (see AddrSpace::PageIn).
+//
+//	The policy is picked at startup, with "-vm <policy>":
+//
+//	fifo	the page that was brought in longest ago
+//	clock	second chance: the clock hand passes over (and clears)
+//		the use bit of pages used since it last came by
+//	eclock	enhanced clock: like clock, but a page that is neither
+//		used nor dirty goes before one that would have to be
+//		written to swap space first
+//	aging	approximate LRU: at each timer interrupt, every page's
+//		use bit is shifted into a counter; the lowest one goes
+//	wsclock	clock over the working set: a page not used for the
+//		last WorkingSetWindow ticks goes, if it is clean.  As we
+//		cannot write pages out in the background, a dirty one is
+//		only taken if no clean one is that old
+//
+//	Only frames that hold a page are candidates: a frame that is
+//	being paged out or filled has no owner (see kernel.h).  With a
+//	TLB, the use and dirty bits of the running program are first
+//	written back from the TLB, so the policies see them all.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef REPLACEMENT_H
+#define REPLACEMENT_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "machine.h"
+#include "stats.h"
+
+enum ReplacementPolicy { ReplaceFIFO,
+			 ReplaceClock,
+			 ReplaceEnhancedClock,
+			 ReplaceAging,
+			 ReplaceWSClock
+};
+
+const int WorkingSetWindow = 50 * TimerTicks;	// wsclock: how long since
+						// a page was last used,
+						// for it to be out of the
+						// working set
+
+class Replacement {
+  public:
+    Replacement(ReplacementPolicy policy);
+					// No frames hold a page yet
+
+    int Victim();			// Pick the frame to page out;
+					// memory must be full
+    void Loaded(int frame);		// A page was just brought into
+					// "frame"
+    void Sample();			// Timer interrupt: shift the use
+					// bits into the aging counters
+
+  private:
+    ReplacementPolicy policy;
+    int hand;				// clock hand: the next frame to look at
+    int loads;				// # of pages brought in so far
+    int loadedAt[NumPhysPages];		// per frame: value of "loads" when
+					// its page came in
+    unsigned int age[NumPhysPages];	// per frame: aging counter
+    int lastUsed[NumPhysPages];		// per frame: when its use bit was
+					// last seen set
+
+    TranslationEntry *Entry(int frame);	// the page table entry of the
+					// page in "frame"; NULL if none
+    void SettleUses();			// count the prefetched pages that
+					// were used, before the bits go
+    int Oldest();			// the frame whose page came in first
+    int ClockVictim();
+    int EnhancedClockVictim();
+    int AgingVictim();
+    int WSClockVictim();
+};
+
+#endif // REPLACEMENT_H
@@ -0,0 +1,92 @@
+// swap.cc
+//	Routines to manage the swap space on the simulated disk.
+//	See swap.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "swap.h"
+#include "main.h"
+#include "synchdisk.h"
+
+//----------------------------------------------------------------------
+// SwapSpace::SwapSpace
+// 	Start with every slot free.
+//----------------------------------------------------------------------
+
+SwapSpace::SwapSpace()
+{
+    inUse = new Bitmap(NumSwapSlots);
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::~SwapSpace
+//----------------------------------------------------------------------
+
+SwapSpace::~SwapSpace()
+{
+    delete inUse;
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::Allocate
+// 	Return a free slot, now in use, or -1 if the disk is full.
+//----------------------------------------------------------------------
+
+int
+SwapSpace::Allocate()
+{
+    return inUse->FindAndSet();
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::Allocate
+// 	Return "slot", now in use, if it is on the disk and free; or -1.
+//	Used to put a page right after its neighbour.
+//----------------------------------------------------------------------
+
+int
+SwapSpace::Allocate(int slot)
+{
+    if (slot >= NumSwapSlots || inUse->Test(slot))
+	return -1;
+    inUse->Mark(slot);
+    return slot;
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::Free
+// 	Give back a slot that Allocate returned.
+//----------------------------------------------------------------------
+
+void
+SwapSpace::Free(int slot)
+{
+    inUse->Clear(slot);
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::ReadPage, SwapSpace::WritePage
+// 	Move one page between "data" and a slot, a sector at a time.
+//	The calling thread waits until the disk is done.
+//----------------------------------------------------------------------
+
+void
+SwapSpace::ReadPage(int slot, char *data)
+{
+    ASSERT(inUse->Test(slot));
+    for (int i = 0; i < SectorsPerPage; i++)
+	kernel->synchDisk->ReadSector(slot * SectorsPerPage + i,
+				      data + i * SectorSize);
+}
+
+void
+SwapSpace::WritePage(int slot, char *data)
+{
+    ASSERT(inUse->Test(slot));
+    for (int i = 0; i < SectorsPerPage; i++)
+	kernel->synchDisk->WriteSector(slot * SectorsPerPage + i,
+				       data + i * SectorSize);
+}
@@ -0,0 +1,47 @@
+// swap.h
+//	Data structures to keep the pages of user programs that do not
+//	fit in physical memory on the simulated disk.
+//
+//	With "-vm", a page is brought into memory only when the program
+//	first touches it (see AddrSpace::PageIn), and a page that has
+//	to make room for another one is written out to a slot of swap
+//	space, if it was modified since it was brought in.
+//
+//	Swap space is the whole SynchDisk, one page per slot: with the
+//	stub file system, nothing else uses the disk.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SWAP_H
+#define SWAP_H
+
+#include "copyright.h"
+#include "bitmap.h"
+#include "machine.h"
+#include "disk.h"
+
+const int SectorsPerPage = divRoundUp(PageSize, SectorSize);
+const int NumSwapSlots = NumSectors / SectorsPerPage;
+
+class SwapSpace {
+  public:
+    SwapSpace();			// All slots are free
+    ~SwapSpace();
+
+    int Allocate();			// Find a free slot; -1 if there
+					// are none left
+    int Allocate(int slot);		// Take "slot", if it is free; -1
+					// if not
+    void Free(int slot);		// Give a slot back
+
+    void ReadPage(int slot, char *data);  // Read or write the page in
+    void WritePage(int slot, char *data); // "slot"; these wait for the
+					// disk, like SynchDisk
+
+  private:
+    Bitmap *inUse;			// which slots hold a page
+};
+
+#endif // SWAP_H
@@ -35,6 +35,10 @@
 #define SC_ThreadExit   14
 #define SC_ThreadJoin   15
 #define SC_PrintInt     16
+#define SC_Fork		17
+#define SC_Sbrk		18
+#define SC_Map		19
+#define SC_Unmap	20
 #define SC_Add		42
 #define SC_MSG		100
 #ifndef IN_ASM
@@ -90,6 +94,21 @@ SpaceId ExecV(int argc, char* argv[]);
  * Return the exit status.
  */
 int Join(SpaceId id); 	
+
+/* Run a copy of this user program, as a child that can be joined.
+ * Both go on from here; the copy sees 0 returned, and the original
+ * the copy's identifier (or a negative error code).  They share
+ * memory until one of them writes to it.
+ */
+SpaceId Fork();
+
+/* Grow the heap, which starts out empty just past the program's data,
+ * by "increment" bytes (or shrink it, if "increment" is negative).
+ * Return the address where it ended before, so that Sbrk(0) tells
+ * where it ends; or -1 if it cannot grow (or shrink) that far.  The
+ * new memory is all zeroes.
+ */
+int Sbrk(int increment);
  
 
 /* File system operations: Create, Remove, Open, Read, Write, Close
@@ -150,6 +169,19 @@ int Seek(int position, OpenFileId id);
  */
 int Close(OpenFileId id);
 
+/* Map the first "length" bytes of the open file "id" into memory, and
+ * return the address they start at; or -1 if there is no room for
+ * them.  Each page is read from the file when it is first touched, and
+ * if it was written to, written back when the file is unmapped or the
+ * program exits.  The file may be closed while it is mapped.
+ */
+int Map(OpenFileId id, int length);
+
+/* Write back and drop the mapping that starts at "addr", as Map
+ * returned it.  Return 0, or -1 if there is no mapping there.
+ */
+int Unmap(int addr);
+
 
 /* User-level thread operations: Fork and Yield.  To allow multiple
  * threads to run within a user program. 
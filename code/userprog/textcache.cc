@@ -0,0 +1,146 @@
+// textcache.cc
+//	Routines to share the code of programs that are running more than
+//	once.  See textcache.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "textcache.h"
+#include "debug.h"
+
+//----------------------------------------------------------------------
+// TextImage::TextImage
+// 	Remember where the code of a program is in memory.
+//
+//	"name", "length", "noffH" -- which program it is
+//	"numPages" -- how many pages of code only it has
+//	"frames" -- the frame holding each of them
+//----------------------------------------------------------------------
+
+TextImage::TextImage(char *name, int length, NoffHeader *noffH,
+		     int numPages, int *frames)
+{
+    this->name = new char[strlen(name) + 1];
+    strcpy(this->name, name);
+    this->length = length;
+    this->noffH = *noffH;
+    this->numPages = numPages;
+    this->frames = new int[numPages];
+    for (int i = 0; i < numPages; i++)
+	this->frames[i] = frames[i];
+    users = 1;
+}
+
+//----------------------------------------------------------------------
+// TextImage::~TextImage
+//----------------------------------------------------------------------
+
+TextImage::~TextImage()
+{
+    delete [] name;
+    delete [] frames;
+}
+
+//----------------------------------------------------------------------
+// TextImage::IsImageOf
+// 	Is this the code of the program "name", with this length and NOFF
+//	header?
+//----------------------------------------------------------------------
+
+bool
+TextImage::IsImageOf(char *name, int length, NoffHeader *noffH)
+{
+    return strcmp(this->name, name) == 0 && this->length == length
+	&& memcmp(&this->noffH, noffH, sizeof(NoffHeader)) == 0;
+}
+
+//----------------------------------------------------------------------
+// TextCache::TextCache
+// 	Initialize an empty text cache.
+//----------------------------------------------------------------------
+
+TextCache::TextCache()
+{
+    images = new List<TextImage *>;
+}
+
+//----------------------------------------------------------------------
+// TextCache::~TextCache
+//----------------------------------------------------------------------
+
+TextCache::~TextCache()
+{
+    while (!images->IsEmpty())
+	delete images->RemoveFront();
+    delete images;
+}
+
+//----------------------------------------------------------------------
+// TextCache::Find
+// 	Return the code of the program "name", with this length and NOFF
+//	header, if some address space is running it, and count the caller
+//	as a user.  Return NULL if it is not running.
+//----------------------------------------------------------------------
+
+TextImage *
+TextCache::Find(char *name, int length, NoffHeader *noffH)
+{
+    ListIterator<TextImage *> iter(images);
+
+    for (; !iter.IsDone(); iter.Next()) {
+	if (iter.Item()->IsImageOf(name, length, noffH)) {
+	    iter.Item()->users++;
+	    DEBUG(dbgAddr, "Share the code of " << name << ", "
+		  << iter.Item()->users << " users");
+	    return iter.Item();
+	}
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// TextCache::Enter
+// 	Enter the program "name" into the cache, as it was just loaded
+//	with its "numPages" pages of code in "frames".  The caller is its
+//	first user.
+//----------------------------------------------------------------------
+
+TextImage *
+TextCache::Enter(char *name, int length, NoffHeader *noffH, int numPages,
+		 int *frames)
+{
+    TextImage *image = new TextImage(name, length, noffH, numPages, frames);
+
+    images->Append(image);
+    return image;
+}
+
+//----------------------------------------------------------------------
+// TextCache::Share
+// 	Count one more user of "image": a clone of an address space that
+//	uses it (see AddrSpace::Clone).
+//----------------------------------------------------------------------
+
+void
+TextCache::Share(TextImage *image)
+{
+    image->users++;
+}
+
+//----------------------------------------------------------------------
+// TextCache::Release
+// 	A user of "image" is done with it.  When the last one is, the
+//	program is no longer running, and leaves the cache.  The frames
+//	are given back by the address spaces themselves.
+//----------------------------------------------------------------------
+
+void
+TextCache::Release(TextImage *image)
+{
+    if (--image->users > 0)
+	return;
+    images->Remove(image);
+    delete image;
+}
@@ -0,0 +1,74 @@
+// textcache.h
+//	Data structures to share the code of a program among all the
+//	address spaces running it.
+//
+//	When a program is loaded, the pages that hold nothing but its
+//	code go into frames as usual, and the program is entered in the
+//	text cache.  A later copy of the same program maps the same
+//	frames, instead of reading its code again into frames of its own.
+//	The shared pages are read-only, so no copy can change them for
+//	the others.
+//
+//	A program is the same if it has the same name, length and NOFF
+//	header, so that one rebuilt in the meantime is not taken for the
+//	old one.  It stays in the cache as long as some address space is
+//	running it; each such space holds a reference to the frames (see
+//	frames.h).
+//
+//	Only programs loaded whole are shared: with "-vm", code pages
+//	come and go one at a time, and a frame has one owner.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include "copyright.h"
+#include "list.h"
+#include "machine.h"
+#include "addrspace.h"		// for NoffHeader
+
+// The code of a program that is running, and where it is in memory
+class TextImage {
+  public:
+    TextImage(char *name, int length, NoffHeader *noffH, int numPages,
+	      int *frames);
+    ~TextImage();
+
+    bool IsImageOf(char *name, int length, NoffHeader *noffH);
+
+    int numPages;			// # of pages of code only
+    int *frames;			// the frame holding each of them
+    int users;				// # of address spaces using it
+
+  private:
+    char *name;				// the program file, to find it by
+    int length;
+    NoffHeader noffH;
+};
+
+class TextCache {
+  public:
+    TextCache();			// No programs are running
+    ~TextCache();
+
+    TextImage *Find(char *name, int length, NoffHeader *noffH);
+					// The code of this program, if a
+					// copy of it is running; the
+					// caller is now one more user.
+					// NULL if there is none
+    TextImage *Enter(char *name, int length, NoffHeader *noffH,
+		     int numPages, int *frames);
+					// A program was just loaded, with
+					// its code in "frames"
+    void Share(TextImage *image);	// One more user, a clone of one
+    void Release(TextImage *image);	// One of its users is done with
+					// it; after the last, it goes
+
+  private:
+    List<TextImage *> *images;		// the programs that are running
+};
+
+#endif // TEXTCACHE_H
@@ -0,0 +1,62 @@
+#!/bin/bash
+
+# Compare the page replacement policies of demand paging (nachos -vm
+# <policy>) on programs that need more memory than the machine has:
+# page faults, the disk traffic to and from swap space, and how many
+# ticks the program took, counting the time it waited for the disk.
+#
+# Usage: ./vmbench.sh [program ...]
+#	(default: seqscan randpages loopset bigmem)
+# The programs must end with Halt(), so that the statistics get printed.
+
+POLICIES=(fifo clock eclock aging wsclock)
+
+if [ $# -gt 0 ]; then
+    PROGS=("$@")
+else
+    PROGS=(seqscan randpages loopset bigmem)
+fi
+
+# Check if script is in the right directory
+if [ ${PWD##*/} != "code" ]; then 
+    echo -e "\n@@@@@ Script should be put in ./code @@@@@\n"
+    exit 1
+fi
+
+# Build nachos
+echo -e "===== Make nachos ====="
+cd build.linux/
+make -j2 > /dev/null 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "Nachos built failed"
+    exit 1
+fi
+cd ..
+
+# Build test programs
+echo -e "===== Make test programs ====="
+cd test
+make ${PROGS[@]} > /dev/null 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "Tests built failed"
+    exit 1
+fi
+
+# Start benchmark; each run is deterministic, so once is enough
+echo -e "===== Start benchmark ====="
+printf "%-10s %-8s %8s %8s %8s %10s %10s\n" program policy faults "swap in" "swap out" ticks idle
+for prog in ${PROGS[@]}; do
+    for policy in ${POLICIES[@]}; do
+	out=$(../build.linux/nachos -vm $policy -e $prog)
+	ticks=$(echo "$out" | sed -n 's/^Ticks: total \([0-9]*\), idle \([0-9]*\).*/\1 \2/p')
+	if [ -z "$ticks" ]; then
+	    echo -e "$prog did not halt under -vm $policy"
+	    continue
+	fi
+	faults=$(echo "$out" | sed -n 's/^Paging: faults \([0-9]*\).*/\1/p')
+	disk=$(echo "$out" | sed -n 's/^Disk I\/O: reads \([0-9]*\), writes \([0-9]*\).*/\1 \2/p')
+	printf "%-10s %-8s %8d %8d %8d %10d %10d\n" $prog $policy $faults $disk $ticks
+    done
+done
+
+exit 0
@@ -47,3 +47,57 @@ struct scnhdr {
         long            s_flags;        /* flags */
       };
  
+
+/* The symbolic header, at f_symptr: where the symbol tables are.
+ * We only use the external symbols and their strings.
+ */
+
+#define  MIPSSYMMAGIC   0x7009
+
+typedef struct hdrr {
+        short   magic;          /* MIPSSYMMAGIC                         */
+        short   vstamp;         /* version stamp                        */
+        long    ilineMax;       /* # of line number entries             */
+        long    cbLine;         /* # of bytes of packed line numbers    */
+        long    cbLineOffset;
+        long    idnMax;         /* dense numbers                        */
+        long    cbDnOffset;
+        long    ipdMax;         /* procedure descriptors                */
+        long    cbPdOffset;
+        long    isymMax;        /* local symbols                        */
+        long    cbSymOffset;
+        long    ioptMax;        /* optimization symbols                 */
+        long    cbOptOffset;
+        long    iauxMax;        /* auxiliary symbols                    */
+        long    cbAuxOffset;
+        long    issMax;         /* local strings                        */
+        long    cbSsOffset;
+        long    issExtMax;      /* external strings                     */
+        long    cbSsExtOffset;
+        long    ifdMax;         /* file descriptors                     */
+        long    cbFdOffset;
+        long    crfd;           /* relative file descriptors            */
+        long    cbRfdOffset;
+        long    iextMax;        /* external symbols                     */
+        long    cbExtOffset;
+      } HDRR;
+
+/* An external symbol.  "bits" packs the symbol type (low 6 bits), its
+ * storage class (next 5 bits) and its auxiliary index; we take them
+ * apart by hand, rather than trust the host compiler's bitfields.
+ */
+
+typedef struct extr {
+        short           reserved;
+        short           ifd;            /* file the symbol is defined in */
+        long            iss;            /* index of its name in the
+                                           external strings */
+        long            value;          /* its address, for a routine */
+        unsigned long   bits;
+      } EXTR;
+
+#define SYM_TYPE(bits)          ((bits) & 0x3f)
+#define SYM_CLASS(bits)         (((bits) >> 6) & 0x1f)
+
+#define stProc          6       /* symbol type of a routine */
+#define scText          1       /* storage class of the text segment */
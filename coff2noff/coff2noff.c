@@ -10,6 +10,10 @@
  * 	ld with  -N -T 0
  * to make sure the object file has no shared text.
  *
+ * If the COFF file has a symbol table, we also write out the address
+ * of each routine, to "<noffFileName>.sym", one "<hex address> <name>"
+ * line per routine, sorted by address, for the Nachos profiler.
+ *
  * Also assumes that the COFF file has at most 3 segments:
  *	.text	-- read-only executable instructions 
  *	.data	-- initialized data
@@ -148,6 +152,75 @@ void Write(int fd, char *buf, int nBytes)
     }
 }
 
+/* sort routines by address */
+static int
+CompareSymbols(const void *a, const void *b)
+{
+    const EXTR *x = (const EXTR *) a, *y = (const EXTR *) b;
+
+    if ((unsigned long) x->value < (unsigned long) y->value)
+	return -1;
+    return (unsigned long) x->value > (unsigned long) y->value;
+}
+
+/* write the routines in the symbol table of the COFF file, if it has one,
+ * to "<noffFileName>.sym"
+ */
+static void
+WriteSymbols(int fdIn, struct filehdr *fileh)
+{
+    HDRR symh;
+    EXTR *ext;
+    char *strings, *symFileName;
+    int i, numProcs;
+    FILE *symFile;
+
+    if (fileh->f_symptr == 0)
+	return;
+    lseek(fdIn, fileh->f_symptr, 0);
+    ReadStruct(fdIn, symh);
+    if (ShortToHost(symh.magic) != MIPSSYMMAGIC)
+	return;
+    symh.issExtMax = WordToHost(symh.issExtMax);
+    symh.cbSsExtOffset = WordToHost(symh.cbSsExtOffset);
+    symh.iextMax = WordToHost(symh.iextMax);
+    symh.cbExtOffset = WordToHost(symh.cbExtOffset);
+
+    strings = malloc(symh.issExtMax + 1);
+    lseek(fdIn, symh.cbSsExtOffset, 0);
+    Read(fdIn, strings, symh.issExtMax);
+    strings[symh.issExtMax] = '\0';
+
+    ext = (EXTR *) malloc(symh.iextMax * sizeof(EXTR));
+    lseek(fdIn, symh.cbExtOffset, 0);
+    Read(fdIn, (char *) ext, symh.iextMax * sizeof(EXTR));
+    for (i = 0, numProcs = 0; i < symh.iextMax; i++) {
+	ext[i].iss = WordToHost(ext[i].iss);
+	ext[i].value = WordToHost(ext[i].value);
+	ext[i].bits = WordToHost(ext[i].bits);
+	if (SYM_TYPE(ext[i].bits) == stProc && SYM_CLASS(ext[i].bits) == scText
+	    && ext[i].iss >= 0 && ext[i].iss < symh.issExtMax)
+	    ext[numProcs++] = ext[i];
+    }
+    qsort(ext, numProcs, sizeof(EXTR), CompareSymbols);
+
+    symFileName = malloc(strlen(noffFileName) + 5);
+    sprintf(symFileName, "%s.sym", noffFileName);
+    symFile = fopen(symFileName, "w");
+    if (symFile == NULL) {
+	perror(symFileName);
+    } else {
+	for (i = 0; i < numProcs; i++)
+	    fprintf(symFile, "%x %s\n", (unsigned int) ext[i].value,
+		    strings + ext[i].iss);
+	fclose(symFile);
+	printf("Wrote %d symbols to %s\n", numProcs, symFileName);
+    }
+    free(symFileName);
+    free(ext);
+    free(strings);
+}
+
 int main(int argc, char **argv)
 {
     int fdIn, fdOut, numsections, i, inNoffFile;
@@ -294,6 +367,9 @@ int main(int argc, char **argv)
     SwapHeader(&noffH);
     
     Write(fdOut, (char *)&noffH, sizeof(NoffHeader));
+
+    fileh.f_symptr = WordToHost(fileh.f_symptr);
+    WriteSymbols(fdIn, &fileh);
     close(fdIn);
     close(fdOut);
     exit(0);